@@ -1,21 +1,656 @@
 #include "Automaton.h"
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 #include <vector>
 #include <deque>
 #include <algorithm>
 #include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
 namespace fa {
 
-  Automaton::Automaton() {
+  namespace {
+
+    /**
+     * Range of the edges labelled with a symbol in a sorted edge list
+     */
+    template<typename Edges>
+    auto symbolRange(Edges& list, char symbol) {
+      auto first = std::lower_bound(list.begin(), list.end(), symbol,
+          [](const auto& edge, char c) { return edge.symbol < c; });
+      auto last = std::upper_bound(first, list.end(), symbol,
+          [](char c, const auto& edge) { return c < edge.symbol; });
+      return std::make_pair(first, last);
+    }
+
+    /**
+     * Remove an edge from a sorted edge list, if present
+     */
+    template<typename Edges, typename Edge>
+    void eraseSorted(Edges& list, const Edge& edge) {
+      auto it = std::lower_bound(list.begin(), list.end(), edge);
+      if (it != list.end() && *it == edge) {
+        list.erase(it);
+      }
+    }
+
+    template<typename Set>
+    void normalize(Set& set) {
+      std::sort(set.begin(), set.end());
+      set.erase(std::unique(set.begin(), set.end()), set.end());
+    }
+
+    /**
+     * Open-addressing hash table from pairs of indices to numbers
+     */
+    class PairTable {
+    public:
+      explicit PairTable(std::pmr::memory_resource* resource)
+      : keys(16, Empty, resource)
+      , values(16, 0, resource)
+      , count(0)
+      {
+      }
+
+      /**
+       * Get the number of a pair, the given number is recorded if the pair is
+       * new. Tell if the pair was inserted.
+       */
+      std::pair<int, bool> insert(int lhs, int rhs, int value) {
+        std::uint64_t key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(lhs)) << 32)
+            | static_cast<std::uint32_t>(rhs);
+        std::size_t slot = lookup(key);
+        if (keys[slot] == key) return { values[slot], false };
+
+        keys[slot] = key;
+        values[slot] = value;
+        if (++count * 2 > keys.size()) {
+          grow();
+        }
+        return { value, true };
+      }
+
+      std::size_t size() const {
+        return count;
+      }
+
+    private:
+      static constexpr std::uint64_t Empty = ~std::uint64_t(0);
+
+      std::size_t lookup(std::uint64_t key) const {
+        std::size_t mask = keys.size() - 1;
+        std::size_t slot = ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+        while (keys[slot] != Empty && keys[slot] != key) {
+          slot = (slot + 1) & mask;
+        }
+        return slot;
+      }
+
+      void grow() {
+        std::pmr::vector<std::uint64_t> oldKeys(keys.size() * 2, Empty, keys.get_allocator());
+        std::pmr::vector<int> oldValues(values.size() * 2, 0, values.get_allocator());
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        for (std::size_t i = 0; i < oldKeys.size(); ++i) {
+          if (oldKeys[i] != Empty) {
+            std::size_t slot = lookup(oldKeys[i]);
+            keys[slot] = oldKeys[i];
+            values[slot] = oldValues[i];
+          }
+        }
+      }
+
+      std::pmr::vector<std::uint64_t> keys;
+      std::pmr::vector<int> values;
+      std::size_t count;
+    };
+
+    // shards of the subsets table in the parallel subset construction
+    constexpr std::size_t Shards = 64;
+
+    // subsets of the frontier taken at once by a thread
+    constexpr std::size_t FrontierChunk = 16;
+
+    // smallest frontier expanded with several threads
+    constexpr std::size_t ParallelFrontier = 256;
+
+    /**
+     * Hash-consed sets of indices: the sorted sets are stored one after the
+     * other in a single pool, and found through an open-addressing table on
+     * their precomputed hashes
+     */
+    class SubsetPool {
+    public:
+      explicit SubsetPool(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : elements(resource)
+      , offsets(1, 0, resource)
+      , hashes(resource)
+      , buckets(16, -1, resource)
+      {
+      }
+
+      /**
+       * Get the number of a sorted set, the set is added if it is new. Tell
+       * if the set was added.
+       */
+      template<typename Set>
+      std::pair<int, bool> intern(const Set& set) {
+        return intern(set, hashSet(set));
+      }
+
+      template<typename Set>
+      std::pair<int, bool> intern(const Set& set, std::uint64_t hash) {
+        std::size_t mask = buckets.size() - 1;
+        std::size_t slot = hash & mask;
+        for (; buckets[slot] >= 0; slot = (slot + 1) & mask) {
+          int id = buckets[slot];
+          if (hashes[id] == hash && std::equal(begin(id), end(id), set.begin(), set.end())) {
+            return { id, false };
+          }
+        }
+
+        int id = hashes.size();
+        buckets[slot] = id;
+        hashes.push_back(hash);
+        elements.insert(elements.end(), set.begin(), set.end());
+        offsets.push_back(elements.size());
+        if (2 * hashes.size() > buckets.size()) {
+          grow();
+        }
+        return { id, true };
+      }
+
+      std::size_t size() const {
+        return hashes.size();
+      }
+
+      std::size_t countElements(int id) const {
+        return offsets[id + 1] - offsets[id];
+      }
+
+      const int* begin(int id) const {
+        return elements.data() + offsets[id];
+      }
+
+      const int* end(int id) const {
+        return elements.data() + offsets[id + 1];
+      }
+
+      template<typename Set>
+      static std::uint64_t hashSet(const Set& set) {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (int index : set) {
+          hash = (hash ^ static_cast<std::uint32_t>(index)) * 1099511628211ull;
+        }
+        return hash;
+      }
+
+    private:
+
+      void grow() {
+        buckets.assign(buckets.size() * 2, -1);
+        std::size_t mask = buckets.size() - 1;
+        for (std::size_t id = 0; id < hashes.size(); ++id) {
+          std::size_t slot = hashes[id] & mask;
+          while (buckets[slot] >= 0) {
+            slot = (slot + 1) & mask;
+          }
+          buckets[slot] = id;
+        }
+      }
+
+      std::pmr::vector<int> elements;
+      std::pmr::vector<std::size_t> offsets;
+      std::pmr::vector<std::uint64_t> hashes;
+      std::pmr::vector<int> buckets;
+    };
+
+    /**
+     * Positions of a regular expression, and the positions that can follow
+     * each one
+     */
+    struct Positions {
+      std::vector<std::vector<char>> symbols;
+      std::vector<std::vector<int>> follow;
+    };
+
+    /**
+     * Part of a regular expression: can it match the empty word, and the
+     * positions that can start and end its words
+     */
+    struct Fragment {
+      bool nullable;
+      std::vector<int> first;
+      std::vector<int> last;
+    };
+
+    /**
+     * Recursive descent parser computing the Glushkov sets while reading
+     */
+    class RegexParser {
+    public:
+      RegexParser(std::string_view regex, Positions& positions)
+      : regex(regex)
+      , pos(0)
+      , positions(positions)
+      {
+      }
+
+      Fragment parse() {
+        Fragment fragment = parseAlternation();
+        if (pos < regex.size()) {
+          fail(regex[pos] == ')' ? "unbalanced parenthesis" : "unexpected character");
+        }
+        return fragment;
+      }
+
+    private:
+      Fragment parseAlternation() {
+        Fragment fragment = parseConcatenation();
+        while (pos < regex.size() && regex[pos] == '|') {
+          ++pos;
+          Fragment other = parseConcatenation();
+          fragment.nullable = fragment.nullable || other.nullable;
+          fragment.first.insert(fragment.first.end(), other.first.begin(), other.first.end());
+          fragment.last.insert(fragment.last.end(), other.last.begin(), other.last.end());
+        }
+        return fragment;
+      }
+
+      Fragment parseConcatenation() {
+        Fragment fragment = { true, {}, {} };
+        while (pos < regex.size() && regex[pos] != '|' && regex[pos] != ')') {
+          Fragment next = parseRepetition();
+          link(fragment.last, next.first);
+          if (fragment.nullable) {
+            fragment.first.insert(fragment.first.end(), next.first.begin(), next.first.end());
+          }
+          if (next.nullable) {
+            next.last.insert(next.last.end(), fragment.last.begin(), fragment.last.end());
+          }
+          fragment.last = std::move(next.last);
+          fragment.nullable = fragment.nullable && next.nullable;
+        }
+        return fragment;
+      }
+
+      Fragment parseRepetition() {
+        Fragment fragment = parseAtom();
+        while (pos < regex.size()) {
+          char c = regex[pos];
+          if (c == '*' || c == '+') {
+            link(fragment.last, fragment.first);
+          }
+          if (c == '*' || c == '?') {
+            fragment.nullable = true;
+          }
+          if (c != '*' && c != '+' && c != '?') break;
+          ++pos;
+        }
+        return fragment;
+      }
+
+      Fragment parseAtom() {
+        char c = regex[pos];
+        switch (c) {
+          case '(': {
+            ++pos;
+            Fragment fragment = parseAlternation();
+            if (pos == regex.size()) fail("unbalanced parenthesis");
+            ++pos;
+            return fragment;
+          }
+          case '[':
+            ++pos;
+            return createPosition(parseClass());
+          case '*':
+          case '+':
+          case '?':
+            fail("nothing to repeat");
+          case ']':
+            fail("unbalanced bracket");
+          default:
+            return createPosition({ parseSymbol() });
+        }
+      }
+
+      std::vector<char> parseClass() {
+        std::vector<char> symbols;
+        while (pos < regex.size() && regex[pos] != ']') {
+          char lower = parseSymbol();
+          if (pos + 1 < regex.size() && regex[pos] == '-' && regex[pos + 1] != ']') {
+            ++pos;
+            char upper = parseSymbol();
+            if (upper < lower) fail("invalid range");
+            for (int c = lower; c <= upper; ++c) {
+              symbols.push_back(c);
+            }
+          } else {
+            symbols.push_back(lower);
+          }
+        }
+        if (pos == regex.size()) fail("unbalanced bracket");
+        ++pos;
+        if (symbols.empty()) fail("empty class");
+
+        std::sort(symbols.begin(), symbols.end());
+        symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+        return symbols;
+      }
+
+      char parseSymbol() {
+        char c = regex[pos++];
+        if (c == '\\') {
+          if (pos == regex.size()) fail("incomplete escape");
+          c = regex[pos++];
+        }
+        if (!isgraph(c)) fail("symbol is not graphic");
+        return c;
+      }
+
+      Fragment createPosition(std::vector<char> symbols) {
+        int position = positions.symbols.size();
+        positions.symbols.push_back(std::move(symbols));
+        positions.follow.emplace_back();
+        return { false, { position }, { position } };
+      }
+
+      void link(const std::vector<int>& last, const std::vector<int>& first) {
+        for (int position : last) {
+          std::vector<int>& follow = positions.follow[position];
+          follow.insert(follow.end(), first.begin(), first.end());
+        }
+      }
+
+      [[noreturn]] void fail(const char* message) const {
+        throw std::invalid_argument(std::string(message) + " at offset " + std::to_string(pos)
+            + " in regular expression");
+      }
+
+      std::string_view regex;
+      std::size_t pos;
+      Positions& positions;
+    };
+
+    /**
+     * Predecessors of each state by symbol, stored contiguously
+     */
+    class ReverseIndex {
+    public:
+      ReverseIndex(std::size_t states, std::size_t symbols)
+      : states(states)
+      , columns(symbols)
+      , offsets(states * symbols + 1, 0)
+      {
+      }
+
+      std::size_t symbols() const {
+        return columns;
+      }
+
+      void add(std::size_t column, int to, int from) {
+        pairs.push_back({ column * states + to, from });
+      }
+
+      void build() {
+        for (const auto& pair : pairs) {
+          offsets[pair.first + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        predecessors.resize(pairs.size());
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const auto& pair : pairs) {
+          predecessors[fill[pair.first]++] = pair.second;
+        }
+        pairs = std::vector<std::pair<std::size_t, int>>();
+      }
+
+      const int* begin(std::size_t column, int to) const {
+        return predecessors.data() + offsets[column * states + to];
+      }
+
+      const int* end(std::size_t column, int to) const {
+        return predecessors.data() + offsets[column * states + to + 1];
+      }
+
+    private:
+      std::size_t states;
+      std::size_t columns;
+      std::vector<std::size_t> offsets;
+      std::vector<int> predecessors;
+      std::vector<std::pair<std::size_t, int>> pairs;
+    };
+
+    /**
+     * Deterministic automaton as a transition table (-1 for no transition),
+     * its start state is 0
+     */
+    struct SubsetTable {
+      std::vector<int> table;
+      std::vector<char> finals;
+    };
+
+    /**
+     * Subset construction on the mirror of an automaton given by its reverse
+     * index: the start set is the set of final states, and a subset is final
+     * if it contains one of the initial states.
+     */
+    SubsetTable determinizeReverse(const ReverseIndex& reverse, const std::vector<int>& start,
+        const std::vector<char>& initial, std::size_t& largestSubset) {
+      std::size_t k = reverse.symbols();
+      SubsetTable result;
+      SubsetPool subsets;
+
+      auto intern = [&](const std::vector<int>& set) {
+        auto interned = subsets.intern(set);
+        if (interned.second) {
+          largestSubset = std::max(largestSubset, set.size());
+          bool final = false;
+          for (int index : set) {
+            final = final || initial[index];
+          }
+          result.finals.push_back(final ? 1 : 0);
+        }
+        return interned.first;
+      };
+
+      intern(start);
+      std::vector<int> next;
+      for (std::size_t current = 0; current < subsets.size(); ++current) {
+        for (std::size_t column = 0; column < k; ++column) {
+          next.clear();
+          for (const int* to = subsets.begin(current); to != subsets.end(current); ++to) {
+            next.insert(next.end(), reverse.begin(column, *to), reverse.end(column, *to));
+          }
+          if (next.empty()) {
+            result.table.push_back(-1);
+            continue;
+          }
+          normalize(next);
+          result.table.push_back(intern(next));
+        }
+      }
+      return result;
+    }
+
+  }
+
+  Automaton::EdgeTable::EdgeTable(std::pmr::memory_resource* resource)
+  : rows(resource)
+  {
+  }
+
+  Automaton::EdgeTable::EdgeTable(const EdgeTable& other, std::pmr::memory_resource* resource)
+  : rows(other.rows, resource)
+  {
+    if (*resource != *other.rows.resource()) {
+      detachLists();
+    }
+  }
+
+  Automaton::EdgeTable::EdgeTable(const EdgeTable& other)
+  : EdgeTable(other, std::pmr::get_default_resource())
+  {
+  }
+
+  Automaton::EdgeTable& Automaton::EdgeTable::operator=(const EdgeTable& other) {
+    rows = other.rows;
+    if (*rows.resource() != *other.rows.resource()) {
+      detachLists();
+    }
+    return *this;
+  }
+
+  Automaton::EdgeTable& Automaton::EdgeTable::operator=(EdgeTable&& other) {
+    bool foreign = *rows.resource() != *other.rows.resource();
+    rows = std::move(other.rows);
+    if (foreign) {
+      detachLists();
+    }
+    return *this;
+  }
+
+  const Automaton::EdgeTable::List& Automaton::EdgeTable::emptyList() {
+    static const List list(std::pmr::null_memory_resource());
+    return list;
+  }
+
+  void Automaton::EdgeTable::detachLists() {
+    // the lists still belong to the memory resource of the copied table
+    std::pmr::polymorphic_allocator<List> allocator(rows.resource());
+    for (auto& row : rows.write()) {
+      if (row) {
+        row = std::allocate_shared<List>(allocator, *row);
+      }
+    }
+  }
+
+  Automaton::EdgeTable::List& Automaton::EdgeTable::write(std::size_t index) {
+    std::shared_ptr<List>& row = rows.write()[index];
+    std::pmr::polymorphic_allocator<List> allocator(rows.resource());
+    if (!row) {
+      row = std::allocate_shared<List>(allocator);
+    } else if (row.use_count() > 1) {
+      row = std::allocate_shared<List>(allocator, *row);
+    } else {
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *row;
+  }
+
+  void Automaton::EdgeTable::resize(std::size_t count) {
+    rows.write().resize(count);
+  }
+
+  void Automaton::EdgeTable::emplace_back() {
+    rows.write().emplace_back();
+  }
+
+  void Automaton::EdgeTable::pop_back() {
+    rows.write().pop_back();
+  }
+
+  void Automaton::EdgeTable::move(std::size_t to, std::size_t from) {
+    Rows& table = rows.write();
+    table[to] = std::move(table[from]);
+  }
+
+  void Automaton::EdgeTable::clear(std::size_t index) {
+    if ((*rows)[index]) {
+      rows.write()[index].reset();
+    }
+  }
+
+  Automaton::ClosureCache::ClosureCache(std::pmr::memory_resource* resource)
+  : table(resource)
+  , valid(false)
+  {
+  }
+
+  Automaton::ClosureCache::ClosureCache(const ClosureCache& other, std::pmr::memory_resource* resource)
+  : table(resource)
+  , valid(false)
+  {
+    // the other closures may be under construction in another thread
+    std::lock_guard<std::mutex> lock(other.mutex);
+    table = CopyOnWrite<EpsilonClosures>(other.table, resource);
+    valid = other.valid.load();
+  }
+
+  Automaton::ClosureCache::ClosureCache(const ClosureCache& other)
+  : ClosureCache(other, std::pmr::get_default_resource())
+  {
+  }
+
+  Automaton::ClosureCache::ClosureCache(ClosureCache&& other) noexcept
+  : table(std::move(other.table))
+  , valid(other.valid.load())
+  {
+    other.valid = false;
+  }
+
+  Automaton::ClosureCache& Automaton::ClosureCache::operator=(const ClosureCache& other) {
+    if (this != &other) {
+      std::lock_guard<std::mutex> lock(other.mutex);
+      table = other.table;
+      valid = other.valid.load();
+    }
+    return *this;
+  }
+
+  Automaton::ClosureCache& Automaton::ClosureCache::operator=(ClosureCache&& other) noexcept {
+    if (this != &other) {
+      if (*table.resource() == *other.table.resource()) {
+        table = std::move(other.table);
+        valid = other.valid.load();
+      } else {
+        // the closures are computed again rather than cloned to the other resource
+        table.reset();
+        valid = false;
+      }
+      other.table.reset();
+      other.valid = false;
+    }
+    return *this;
+  }
+
+  Automaton::Automaton()
+  : Automaton(std::pmr::get_default_resource())
+  {
+  }
+
+  Automaton::Automaton(std::pmr::memory_resource* resource)
+  : alphabet(resource)
+  , states(resource)
+  , edges(resource)
+  , reverse(resource)
+  , closures(resource)
+  {
+  }
+
+  Automaton::Automaton(const Automaton& other, std::pmr::memory_resource* resource)
+  : alphabet(other.alphabet, resource)
+  , states(other.states, resource)
+  , edges(other.edges, resource)
+  , reverse(other.reverse, resource)
+  , reverseIndexed(other.reverseIndexed)
+  , transitionCount(other.transitionCount)
+  , epsilonCount(other.epsilonCount)
+  , closures(other.closures, resource)
+  {
   }
 
   bool Automaton::isValid() const {
     if (alphabet.empty()) return false;
-    if (states.empty()) return false;
+    if (states->ids.empty()) return false;
     return true;
   }
 
@@ -29,8 +664,21 @@ namespace fa {
   bool Automaton::removeSymbol(char symbol) {
     if (!hasSymbol(symbol)) return false;
 
-    for (auto [state, mapChar] : transitions) {
-        mapChar.erase(symbol);
+    auto erase = [symbol](EdgeTable& table) {
+      std::size_t count = 0;
+      for (std::size_t index = 0; index < table.size(); ++index) {
+        auto range = symbolRange(table[index], symbol);
+        if (range.first == range.second) continue;
+        count += std::distance(range.first, range.second);
+        auto& list = table.write(index);
+        auto first = symbolRange(list, symbol);
+        list.erase(first.first, first.second);
+      }
+      return count;
+    };
+    transitionCount -= erase(edges);
+    if (reverseIndexed) {
+      erase(reverse);
     }
     
     alphabet.erase(symbol);
@@ -45,626 +693,2049 @@ namespace fa {
     return alphabet.size();
   }
 
+  int Automaton::indexOf(int state) const {
+    auto it = states->indices.find(state);
+    if (it == states->indices.end()) return -1;
+    return it->second;
+  }
+
   bool Automaton::addState(int state) {
     if (state < 0) return false;
     if (hasState(state)) return false;
-    states.insert({state, NONE});
+    StateTable& table = states.write();
+    table.indices.insert({state, static_cast<int>(table.ids.size())});
+    table.ids.push_back(state);
+    table.kinds.push_back(NONE);
+    edges.emplace_back();
+    if (reverseIndexed) {
+      reverse.emplace_back();
+    }
     return true;
   }
 
   bool Automaton::removeState(int state) {
-    if (!hasState(state)) return false;
-    
-    transitions.erase(state);
+    int index = indexOf(state);
+    if (index < 0) return false;
+
+    // the last state takes the place of the removed one
+    int last = static_cast<int>(states->ids.size()) - 1;
+
+    auto eraseEdge = [this](const Edge& edge) {
+      --transitionCount;
+      if (edge.symbol == fa::Epsilon) --epsilonCount;
+    };
+    if (reverseIndexed) {
+      // only the neighbours of the removed and of the last state are visited
+      for (const auto& edge : edges[index]) {
+        eraseEdge(edge);
+        eraseSorted(reverse.write(edge.to), Edge{ edge.symbol, index });
+      }
+      edges.clear(index);
+      for (const auto& edge : reverse[index]) {
+        eraseEdge(edge);
+        eraseSorted(edges.write(edge.to), Edge{ edge.symbol, index });
+      }
+      reverse.clear(index);
+
+      auto redirect = [index, last](EdgeTable& table, int at) {
+        const auto& list = table[at];
+        bool found = std::any_of(list.begin(), list.end(), [last](const Edge& edge) {
+          return edge.to == last;
+        });
+        if (!found) return;
+        auto& modified = table.write(at);
+        for (auto& edge : modified) {
+          if (edge.to == last) edge.to = index;
+        }
+        std::sort(modified.begin(), modified.end());
+      };
+      if (index != last) {
+        for (const auto& edge : edges[last]) {
+          if (edge.to != last) redirect(reverse, edge.to);
+        }
+        for (const auto& edge : reverse[last]) {
+          if (edge.to != last) redirect(edges, edge.to);
+        }
+        redirect(edges, last);
+        redirect(reverse, last);
+        reverse.move(index, last);
+      }
+      reverse.pop_back();
+    } else {
+      std::for_each(edges[index].begin(), edges[index].end(), eraseEdge);
+      edges.clear(index);
+
+      // only the lists leading to the removed or to the last state are modified
+      for (std::size_t from = 0; from < edges.size(); ++from) {
+        bool touched = std::any_of(edges[from].begin(), edges[from].end(), [index, last](const Edge& edge) {
+          return edge.to == index || edge.to == last;
+        });
+        if (!touched) continue;
+
+        auto& list = edges.write(from);
+        auto removed = [index](const Edge& edge) {
+          return edge.to == index;
+        };
+        for (const auto& edge : list) {
+          if (removed(edge)) eraseEdge(edge);
+        }
+        list.erase(std::remove_if(list.begin(), list.end(), removed), list.end());
 
-    for (auto [src, mapChar] : transitions) {
-      for (auto [alpha, dest] : mapChar) {
-        dest.erase(state);
+        bool moved = false;
+        for (auto& edge : list) {
+          if (edge.to == last) {
+            edge.to = index;
+            moved = true;
+          }
+        }
+        if (moved) {
+          std::sort(list.begin(), list.end());
+        }
       }
     }
 
-    states.erase(state);
+    StateTable& table = states.write();
+    if (index != last) {
+      table.ids[index] = table.ids[last];
+      table.kinds[index] = table.kinds[last];
+      edges.move(index, last);
+      table.indices[table.ids[index]] = index;
+    }
+    table.ids.pop_back();
+    table.kinds.pop_back();
+    edges.pop_back();
+    table.indices.erase(state);
+
+    closures.valid = false;
     return true;
   }
 
   bool Automaton::hasState(int state) const {
-    return states.count(state) == 1;
+    return states->indices.count(state) == 1;
   }
 
   std::size_t Automaton::countStates() const {
-    return states.size();
+    return states->ids.size();
   }
 
   void Automaton::setStateInitial(int state) {
-    if (!hasState(state)) return;
-    if (isStateInitial(state)) return;
-    if (isStateFinal(state)) {
-      states[state] = BOTH;
+    int index = indexOf(state);
+    if (index < 0) return;
+    if (isInitialAt(index)) return;
+    if (isFinalAt(index)) {
+      states.write().kinds[index] = BOTH;
       return;
     }
-    states[state] = INITIAL;
+    states.write().kinds[index] = INITIAL;
   }
 
   bool Automaton::isStateInitial(int state) const {
-    if (states.count(state) == 0) return false;
-    return states.at(state) == INITIAL || states.at(state) == BOTH;
+    int index = indexOf(state);
+    if (index < 0) return false;
+    return isInitialAt(index);
   }
 
   void Automaton::setStateFinal(int state) {
-    if (!hasState(state)) return;
-    if (isStateFinal(state)) return;
-    if (isStateInitial(state)) {
-      states[state] = BOTH;
+    int index = indexOf(state);
+    if (index < 0) return;
+    if (isFinalAt(index)) return;
+    if (isInitialAt(index)) {
+      states.write().kinds[index] = BOTH;
       return;
     }
-    states[state] = FINAL;
+    states.write().kinds[index] = FINAL;
   }
 
   bool Automaton::isStateFinal(int state) const {
-    if (states.count(state) == 0) return false;
-    return states.at(state) == FINAL || states.at(state) == BOTH;
+    int index = indexOf(state);
+    if (index < 0) return false;
+    return isFinalAt(index);
   }
 
   bool Automaton::addTransition(int from, char alpha, int to) {
-    if (!hasState(from)) return false;
-    if (!hasState(to)) return false;
+    int src = indexOf(from);
+    if (src < 0) return false;
+    int dst = indexOf(to);
+    if (dst < 0) return false;
     if (!hasSymbol(alpha) && alpha != fa::Epsilon) return false;
-    if (hasTransition(from, alpha, to)) return false;
 
-    transitions[from][alpha].insert(to);
+    Edge edge = { alpha, dst };
+    const auto& list = edges[src];
+    auto it = std::lower_bound(list.begin(), list.end(), edge);
+    if (it != list.end() && *it == edge) return false;
+
+    auto position = it - list.begin();
+    auto& modified = edges.write(src);
+    modified.insert(modified.begin() + position, edge);
+    if (reverseIndexed) {
+      auto& incoming = reverse.write(dst);
+      Edge back = { alpha, src };
+      incoming.insert(std::lower_bound(incoming.begin(), incoming.end(), back), back);
+    }
+    ++transitionCount;
+    if (alpha == fa::Epsilon) {
+      ++epsilonCount;
+      closures.valid = false;
+    }
     return true;
   }
 
   bool Automaton::removeTransition(int from, char alpha, int to) {
-    auto itState = transitions.find(from);
-    if (itState == transitions.end()) return false;
-
-    auto itChar = itState->second.find(alpha);
-    if (itChar == itState->second.end()) return false;
-
-    bool removed = itChar->second.erase(to) > 0;
-    
-    if (itChar->second.empty()) {
-        itState->second.erase(itChar);
+    int src = indexOf(from);
+    if (src < 0) return false;
+    int dst = indexOf(to);
+    if (dst < 0) return false;
+
+    Edge edge = { alpha, dst };
+    const auto& list = edges[src];
+    auto it = std::lower_bound(list.begin(), list.end(), edge);
+    if (it == list.end() || !(*it == edge)) return false;
+
+    auto position = it - list.begin();
+    auto& modified = edges.write(src);
+    modified.erase(modified.begin() + position);
+    if (reverseIndexed) {
+      eraseSorted(reverse.write(dst), Edge{ alpha, src });
     }
-    
-    if (itState->second.empty()) {
-        transitions.erase(itState);
+    --transitionCount;
+    if (alpha == fa::Epsilon) {
+      --epsilonCount;
+      closures.valid = false;
     }
-
-    return removed;
+    return true;
   }
 
   bool Automaton::hasTransition(int from, char alpha, int to) const {
-    auto itState = transitions.find(from);
-    if (itState == transitions.end()) return false;
+    int src = indexOf(from);
+    if (src < 0) return false;
+    int dst = indexOf(to);
+    if (dst < 0) return false;
 
-    auto itChar = itState->second.find(alpha);
-    if (itChar == itState->second.end()) return false;
-
-    return itChar->second.count(to) == 1;
+    const auto& list = edges[src];
+    return std::binary_search(list.begin(), list.end(), Edge{ alpha, dst });
   }
 
   std::size_t Automaton::countTransitions() const {
-    std::size_t count = 0;
-    for (const auto& [state, mapChar] : transitions) {
-        for (const auto& [alpha, dests] : mapChar) {
-            count += dests.size();
-        }
+    return transitionCount;
+  }
+
+  void Automaton::setReverseIndex(bool enabled) {
+    if (enabled == reverseIndexed) return;
+    reverseIndexed = enabled;
+    if (enabled) {
+      buildReverseIndex();
+    } else {
+      reverse = EdgeTable(memoryResource());
     }
-    return count;
+  }
+
+  bool Automaton::hasReverseIndex() const {
+    return reverseIndexed;
   }
 
   void Automaton::prettyPrint(std::ostream& os) const {
+    std::vector<int> order(states->ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int lhs, int rhs) { return states->ids[lhs] < states->ids[rhs]; });
+
+    auto printTargets = [&](int index, char alpha) {
+      auto range = symbolRange(edges[index], alpha);
+      std::vector<int> dests;
+      for (auto it = range.first; it != range.second; ++it) {
+        dests.push_back(states->ids[it->to]);
+      }
+      std::sort(dests.begin(), dests.end());
+      for (int dest : dests) {
+        os << dest << " ";
+      }
+      os << std::endl;
+    };
+
     os << "Initial states : "<< std::endl;
-    for (auto state : states) {
-      if(isStateInitial(state.first)){
-        os << state.first << " ";
+    for (int index : order) {
+      if (isInitialAt(index)) {
+        os << states->ids[index] << " ";
       }
     }
     os << std::endl;
     os << "Final states : " << std::endl;
-    for (auto state : states) {
-      if(isStateFinal(state.first)){
-        os << state.first << " ";
+    for (int index : order) {
+      if (isFinalAt(index)) {
+        os << states->ids[index] << " ";
       }
     }
     os << std::endl;
     os << "Transitions:" << std::endl;
     
-    for (auto state : states) {
-      os << "For state " << state.first << ":" << std::endl;
+    for (int index : order) {
+      os << "For state " << states->ids[index] << ":" << std::endl;
       
-      auto itTrans = transitions.find(state.first);
-      if (itTrans != transitions.end()) {
-          for (auto c : alphabet) {
-            if (itTrans->second.count(c)) {
-                os << "  For letter " << c << ": ";
-                for (int dest : itTrans->second.at(c)) {
-                    os << dest << " ";
-                }
-                os << std::endl;
-            }
-          }
-          if (itTrans->second.count(fa::Epsilon)) {
-             os << "  For letter Epsilon: ";
-             for (int dest : itTrans->second.at(fa::Epsilon)) {
-                 os << dest << " ";
-             }
-             os << std::endl;
-          }
+      for (auto c : alphabet) {
+        auto range = symbolRange(edges[index], c);
+        if (range.first != range.second) {
+          os << "  For letter " << c << ": ";
+          printTargets(index, c);
+        }
+      }
+      auto range = symbolRange(edges[index], fa::Epsilon);
+      if (range.first != range.second) {
+        os << "  For letter Epsilon: ";
+        printTargets(index, fa::Epsilon);
       }
     }
   }
 
   bool Automaton::hasEpsilonTransition() const {
-    for (const auto [state, mapChar] : transitions) {
-      if (mapChar.count(fa::Epsilon) > 0 && !mapChar.at(fa::Epsilon).empty())
-        return true;
-    }
-    return false;
+    return epsilonCount > 0;
   }
 
   bool Automaton::isDeterministic() const {
     if (hasEpsilonTransition()) return false;
 
     int cpt = 0;
-    for (auto state : states) {
-      if (isStateInitial(state.first)) {
+    for (std::size_t index = 0; index < states->ids.size(); ++index) {
+      if (isInitialAt(index)) {
         cpt++;
       }
     }
     if (cpt != 1) return false;
 
-    for (const auto& [state, mapChar] : transitions) {
-        for (const auto& [alpha, dests] : mapChar) {
-            if (dests.size() > 1) return false;
-        }
+    for (const auto& list : edges) {
+      for (std::size_t i = 1; i < list.size(); ++i) {
+        if (list[i].symbol == list[i - 1].symbol) return false;
+      }
     }
     return true;
   }
 
   bool Automaton::isComplete() const {
-    for (auto state : states) {
-      auto itTrans = transitions.find(state.first);
-      
-      if (itTrans == transitions.end()) {
-          if (!alphabet.empty()) return false;
-          continue;
-      }
-
-      for (char c : alphabet) {
-          if (itTrans->second.find(c) == itTrans->second.end() || 
-              itTrans->second.at(c).empty()) {
-              return false;
-          }
+    for (const auto& list : edges) {
+      std::size_t symbols = 0;
+      for (std::size_t i = 0; i < list.size(); ++i) {
+        if (list[i].symbol == fa::Epsilon) continue;
+        if (i == 0 || list[i].symbol != list[i - 1].symbol) {
+          symbols++;
+        }
       }
+      if (symbols != alphabet.size()) return false;
     }
     return true;
   }
 
   Automaton Automaton::createComplete(const Automaton& automaton) {
-    if (automaton.isComplete()) return automaton;
+    Automaton comp(automaton, automaton.memoryResource());
+    if (comp.isComplete()) return comp;
 
-    Automaton comp = automaton;
-    int newState = 0;
-    while (comp.hasState(newState)) {
-      newState++;
-    }
-    comp.addState(newState);
+    comp.makeComplete();
+    return comp;
+  }
 
-    for (auto c : comp.alphabet) {
-        comp.addTransition(newState, c, newState);
-    }
+  Automaton Automaton::createComplete(Automaton&& automaton) {
+    automaton.makeComplete();
+    return std::move(automaton);
+  }
 
+  void Automaton::makeComplete() {
+    if (isComplete()) return;
 
-    for (auto s : comp.states) {
-        for (auto c : comp.alphabet) {
-             if (!comp.hasTransition(s.first, c, newState) &&
-                 (!comp.transitions.count(s.first) || 
-                  !comp.transitions.at(s.first).count(c) ||
-                  comp.transitions.at(s.first).at(c).empty())) 
-             {
-                 comp.addTransition(s.first, c, newState);
-             }
+    int newState = 0;
+    while (hasState(newState)) {
+      newState++;
+    }
+    addState(newState);
+    int sink = indexOf(newState);
+
+    // the complete lists are left shared
+    for (std::size_t index = 0; index < edges.size(); ++index) {
+      bool complete = std::all_of(alphabet.begin(), alphabet.end(), [this, index](char c) {
+        auto range = symbolRange(edges[index], c);
+        return range.first != range.second;
+      });
+      if (complete) continue;
+
+      auto& list = edges.write(index);
+      for (auto c : alphabet) {
+        auto range = symbolRange(list, c);
+        if (range.first == range.second) {
+          list.insert(range.first, Edge{ c, sink });
+          transitionCount++;
+          if (reverseIndexed) {
+            reverse.write(sink).push_back({ c, static_cast<int>(index) });
+          }
         }
+      }
+    }
+    if (reverseIndexed) {
+      auto& incoming = reverse.write(sink);
+      std::sort(incoming.begin(), incoming.end());
     }
-
-    return comp;
   }
 
   Automaton Automaton::createComplement(const Automaton& automaton) {
     Automaton res = createDeterministic(automaton);
-    res = createComplete(res);
+    res.complementInPlace();
+    return res;
+  }
 
-    for (auto s : res.states) {
-      int state = s.first;
-      if (res.isStateFinal(state)) {
-        if (res.states[state] == BOTH) res.states[state] = INITIAL;
-        else res.states[state] = NONE;
-      } else {
-        if (res.states[state] == INITIAL) res.states[state] = BOTH;
-        else res.states[state] = FINAL;
+  Automaton Automaton::createComplement(Automaton&& automaton) {
+    automaton.complementInPlace();
+    return std::move(automaton);
+  }
+
+  void Automaton::complementInPlace() {
+    determinizeInPlace();
+    makeComplete();
+
+    for (auto& kind : states.write().kinds) {
+      switch (kind) {
+        case NONE: kind = FINAL; break;
+        case INITIAL: kind = BOTH; break;
+        case FINAL: kind = NONE; break;
+        case BOTH: kind = INITIAL; break;
       }
     }
-    return res;
   }
 
   Automaton Automaton::createMirror(const Automaton& automaton) {
-    Automaton mirror;
+    Automaton mirror(automaton.memoryResource());
     mirror.alphabet = automaton.alphabet;
-
-    for (auto state : automaton.states) {
-      mirror.addState(state.first);
-      if (automaton.isStateInitial(state.first)) {
-        mirror.setStateFinal(state.first);
-      }
-      if (automaton.isStateFinal(state.first)) {
-        mirror.setStateInitial(state.first);
-      }
+    StateTable& table = mirror.states.write();
+    table.ids = automaton.states->ids;
+    table.indices = automaton.states->indices;
+    mirror.transitionCount = automaton.transitionCount;
+    mirror.epsilonCount = automaton.epsilonCount;
+
+    table.kinds.reserve(automaton.states->kinds.size());
+    for (std::size_t index = 0; index < automaton.states->ids.size(); ++index) {
+      bool initial = automaton.isFinalAt(index);
+      bool final = automaton.isInitialAt(index);
+      table.kinds.push_back(initial ? (final ? BOTH : INITIAL) : (final ? FINAL : NONE));
     }
 
-    for (const auto& [from, mapChar] : automaton.transitions) {
-        for (const auto& [alpha, dests] : mapChar) {
-            for (int to : dests) {
-                mirror.addTransition(to, alpha, from);
-            }
-        }
+    mirror.edges.resize(automaton.edges.size());
+    for (std::size_t from = 0; from < automaton.edges.size(); ++from) {
+      for (const auto& edge : automaton.edges[from]) {
+        mirror.edges.write(edge.to).push_back({ edge.symbol, static_cast<int>(from) });
+      }
     }
+    mirror.sortEdges();
 
     return mirror;
   }
 
-  std::set<int> Automaton::makeTransition(const std::set<int>& origin, char alpha) const {
-    std::set<int> result;
-    if (!hasSymbol(alpha)) return result;
-    for (auto from : origin) {
-        auto itState = transitions.find(from);
-        if (itState != transitions.end()) {
-            auto itChar = itState->second.find(alpha);
-            if (itChar != itState->second.end()) {
-                result.insert(itChar->second.begin(), itChar->second.end());
-            }
-        }
+  Automaton Automaton::createMirror(Automaton&& automaton) {
+    for (auto& kind : automaton.states.write().kinds) {
+      switch (kind) {
+        case INITIAL: kind = FINAL; break;
+        case FINAL: kind = INITIAL; break;
+        default: break;
+      }
     }
-    return result;
-  }
 
-  std::set<int> Automaton::readString(const std::string& word) const {
-    std::set<int> path;
-    for (auto state : states) {
-      if (state.second == INITIAL || state.second == BOTH) {
-        path.insert(state.first);
+    // the index of the incoming edges is exactly the mirrored edges
+    if (automaton.reverseIndexed) {
+      std::swap(automaton.edges, automaton.reverse);
+      automaton.closures.valid = false;
+      return std::move(automaton);
+    }
+
+    // the edges are reversed list by list, each list is freed once read
+    EdgeTable reversed(automaton.memoryResource());
+    reversed.resize(automaton.edges.size());
+    for (std::size_t from = 0; from < automaton.edges.size(); ++from) {
+      for (const auto& edge : automaton.edges[from]) {
+        reversed.write(edge.to).push_back({ edge.symbol, static_cast<int>(from) });
       }
+      automaton.edges.clear(from);
     }
+    automaton.edges = std::move(reversed);
+    automaton.sortEdges();
+    automaton.closures.valid = false;
+    return std::move(automaton);
+  }
+
+  const Automaton::EpsilonClosures& Automaton::epsilonClosures() const {
+    if (closures.valid) return *closures.table;
+
+    // the closures are computed once even if several threads need them
+    std::lock_guard<std::mutex> lock(closures.mutex);
+    if (closures.valid) return *closures.table;
+
+    // the closures shared with the copies are left untouched
+    closures.table.reset();
+    EpsilonClosures& result = closures.table.write();
+    std::size_t n = states->ids.size();
+    result.component.assign(n, -1);
+    result.sets.clear();
+
+    // Tarjan's algorithm on the epsilon-transitions: the components are found
+    // in reverse topological order, so the closures of the components reached
+    // from a component are already known when it is completed.
+    struct Frame {
+      int index;
+      std::size_t edge;
+      std::size_t end;
+    };
+
+    std::vector<int> order(n, -1);
+    std::vector<int> low(n, 0);
+    std::vector<char> onStack(n, 0);
+    std::vector<int> stack;
+    std::vector<Frame> frames;
+    int rank = 0;
+
+    auto visit = [&](int index) {
+      order[index] = low[index] = rank++;
+      stack.push_back(index);
+      onStack[index] = 1;
+      auto range = symbolRange(edges[index], fa::Epsilon);
+      frames.push_back({ index,
+          static_cast<std::size_t>(range.first - edges[index].begin()),
+          static_cast<std::size_t>(range.second - edges[index].begin()) });
+    };
+
+    for (std::size_t root = 0; root < n; ++root) {
+      if (order[root] >= 0) continue;
+      auto range = symbolRange(edges[root], fa::Epsilon);
+      if (range.first == range.second) continue;
+      visit(root);
+
+      while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.edge != frame.end) {
+          int to = edges[frame.index][frame.edge++].to;
+          if (order[to] < 0) {
+            visit(to);
+          } else if (onStack[to]) {
+            low[frame.index] = std::min(low[frame.index], order[to]);
+          }
+          continue;
+        }
+
+        int index = frame.index;
+        frames.pop_back();
+        if (!frames.empty()) {
+          int parent = frames.back().index;
+          low[parent] = std::min(low[parent], low[index]);
+        }
+        if (low[index] != order[index]) continue;
+
+        int component = static_cast<int>(result.sets.size());
+        std::pmr::vector<int> closure(result.sets.get_allocator());
+        int member;
+        do {
+          member = stack.back();
+          stack.pop_back();
+          onStack[member] = 0;
+          closure.push_back(member);
+          result.component[member] = component;
+        } while (member != index);
+
+        std::size_t members = closure.size();
+        for (std::size_t i = 0; i < members; ++i) {
+          auto targets = symbolRange(edges[closure[i]], fa::Epsilon);
+          for (auto it = targets.first; it != targets.second; ++it) {
+            int other = result.component[it->to];
+            if (other != component) {
+              closure.insert(closure.end(), result.sets[other].begin(), result.sets[other].end());
+            }
+          }
+        }
+        normalize(closure);
+        result.sets.push_back(std::move(closure));
+      }
+    }
+
+    closures.valid = true;
+    return result;
+  }
+
+  const std::pmr::vector<int>* Automaton::closureOf(int index) const {
+    if (epsilonCount == 0) return nullptr;
+    const EpsilonClosures& table = epsilonClosures();
+    if (static_cast<std::size_t>(index) >= table.component.size()) return nullptr;
+    int component = table.component[index];
+    if (component < 0) return nullptr;
+    return &table.sets[component];
+  }
+
+  std::vector<int> Automaton::initialClosure() const {
+    std::vector<int> set;
+    for (std::size_t index = 0; index < states->ids.size(); ++index) {
+      if (isInitialAt(index)) {
+        addClosure(set, index);
+      }
+    }
+    normalize(set);
+    return set;
+  }
+
+  std::pmr::vector<int> Automaton::initialClosure(std::pmr::memory_resource* resource) const {
+    std::pmr::vector<int> set(resource);
+    for (std::size_t index = 0; index < states->ids.size(); ++index) {
+      if (isInitialAt(index)) {
+        addClosure(set, index);
+      }
+    }
+    normalize(set);
+    return set;
+  }
+
+  std::vector<int> Automaton::makeClosedTransition(const std::vector<int>& origin, char alpha) const {
+    std::vector<int> result;
+    if (!hasSymbol(alpha)) return result;
+    for (int from : origin) {
+      auto range = symbolRange(edges[from], alpha);
+      for (auto it = range.first; it != range.second; ++it) {
+        addClosure(result, it->to);
+      }
+    }
+    normalize(result);
+    return result;
+  }
+
+  std::set<int> Automaton::makeTransition(const std::set<int>& origin, char alpha) const {
+    std::vector<int> from;
+    for (int state : origin) {
+      int index = indexOf(state);
+      if (index >= 0) {
+        addClosure(from, index);
+      }
+    }
+    normalize(from);
+
+    std::set<int> result;
+    for (int index : makeClosedTransition(from, alpha)) {
+      result.insert(states->ids[index]);
+    }
+    return result;
+  }
+
+  std::vector<int> Automaton::readIndices(const std::string& word) const {
+    std::vector<int> path = initialClosure();
     for (auto c : word) {
-      path = makeTransition(path, c);
+      if (path.empty()) break;
+      path = makeClosedTransition(path, c);
+    }
+    return path;
+  }
+
+  std::set<int> Automaton::readString(const std::string& word) const {
+    std::set<int> path;
+    for (int index : readIndices(word)) {
+      path.insert(states->ids[index]);
     }
     return path;
   }
 
   bool Automaton::match(const std::string& word) const {
-    std::set<int> match = readString(word);
-    for (auto state : match) {
-      if (isStateFinal(state)) return true;
+    std::vector<int> match = readIndices(word);
+    for (int index : match) {
+      if (isFinalAt(index)) return true;
     }
     return false;
   }
 
   bool Automaton::isLanguageEmpty() const {
-    // Construction du graphe (voisin) plus rapide
-    std::unordered_map<int, std::vector<int>> voisin;
-    
-    for (const auto& [from, mapChar] : transitions) {
-        for (const auto& [alpha, dests] : mapChar) {
-            for (int to : dests) {
-                voisin[from].push_back(to);
-            }
-        }
-    }
-
     std::vector<int> stack;
-    std::set<int> visited;
-
+    std::vector<char> visited(states->ids.size(), 0);
 
-    for (auto t : states) {
-      int s = t.first;
-      if (isStateInitial(s)) {
-          if (isStateFinal(s)) return false;
-          stack.push_back(s);
-          visited.insert(s);
+    for (std::size_t index = 0; index < states->ids.size(); ++index) {
+      if (isInitialAt(index)) {
+          stack.push_back(index);
+          visited[index] = 1;
       } 
     }
 
     while (!stack.empty()) {
-      int state = stack.back();
+      int index = stack.back();
       stack.pop_back();
 
-      if (isStateFinal(state)) {
+      if (isFinalAt(index)) {
         return false;
       }
 
-      if (voisin.count(state)) {
-          for (int next : voisin[state]) {
-            if (visited.find(next) == visited.end()) {
-              stack.push_back(next);
-              visited.insert(next);
-            }
-          }
+      for (const auto& edge : edges[index]) {
+        if (!visited[edge.to]) {
+          stack.push_back(edge.to);
+          visited[edge.to] = 1;
+        }
       }
     }
 
     return true;
   }
 
+  void Automaton::keepStates(const std::vector<char>& keep) {
+    std::size_t n = states->ids.size();
+    std::vector<int> renamed(n, -1);
+    int count = 0;
+    for (std::size_t index = 0; index < n; ++index) {
+      if (keep[index]) {
+        renamed[index] = count++;
+      }
+    }
+    if (static_cast<std::size_t>(count) == n) return;
+
+    // the renaming preserves the order of the indices, so the edges stay
+    // sorted, and the lists whose targets keep their index stay shared
+    auto compact = [&renamed, count](EdgeTable& lists) {
+      for (std::size_t index = 0; index < renamed.size(); ++index) {
+        int target = renamed[index];
+        if (target < 0) continue;
+
+        bool unchanged = std::all_of(lists[index].begin(), lists[index].end(), [&renamed](const Edge& edge) {
+          return renamed[edge.to] == edge.to;
+        });
+        if (!unchanged) {
+          auto& list = lists.write(index);
+          auto end = std::remove_if(list.begin(), list.end(), [&renamed](const Edge& edge) {
+            return renamed[edge.to] < 0;
+          });
+          list.erase(end, list.end());
+          for (auto& edge : list) {
+            edge.to = renamed[edge.to];
+          }
+        }
+        if (static_cast<std::size_t>(target) != index) {
+          lists.move(target, index);
+        }
+      }
+      lists.resize(count);
+    };
+    compact(edges);
+    if (reverseIndexed) {
+      compact(reverse);
+    }
+
+    StateTable& table = states.write();
+    table.indices.clear();
+    transitionCount = 0;
+    epsilonCount = 0;
+    for (std::size_t index = 0; index < n; ++index) {
+      int target = renamed[index];
+      if (target < 0) continue;
+
+      const auto& list = edges[target];
+      transitionCount += list.size();
+      epsilonCount += symbolRange(list, fa::Epsilon).second - list.begin();
+
+      table.ids[target] = table.ids[index];
+      table.kinds[target] = table.kinds[index];
+      table.indices.insert({ table.ids[target], target });
+    }
+    table.ids.resize(count);
+    table.kinds.resize(count);
+    closures.valid = false;
+  }
+
   void Automaton::removeNonAccessibleStates() {
     std::vector<int> queue;
-    std::set<int> visited;
+    std::vector<char> visited(states->ids.size(), 0);
 
-    bool initial = false;
-    for (auto s : states) {
-      if (isStateInitial(s.first)) {
-          queue.push_back(s.first);
-          visited.insert(s.first);
-          initial = true;
+    for (std::size_t index = 0; index < states->ids.size(); ++index) {
+      if (isInitialAt(index)) {
+          queue.push_back(index);
+          visited[index] = 1;
       }
     }
 
-    if (!initial) {
-        states.clear();
-        transitions.clear();
-        return;
-    }
-
     while (!queue.empty()) {
-      int state = queue.back();
+      int index = queue.back();
       queue.pop_back();
-      auto itTrans = transitions.find(state);
-      if (itTrans != transitions.end()) {
-          for (auto& [alpha, dests] : itTrans->second) {
-              for (int next : dests) {
-                  if (visited.find(next) == visited.end()) {
-                      queue.push_back(next);
-                      visited.insert(next);
-                  }
-              }
-          }
+      for (const auto& edge : edges[index]) {
+        if (!visited[edge.to]) {
+          queue.push_back(edge.to);
+          visited[edge.to] = 1;
+        }
       }
     }
     
-    std::vector<int> remove;
-    for (auto current : states) {
-      if (visited.find(current.first) == visited.end()) {
-        remove.push_back(current.first);
-      }
-    }
-    for (auto rm : remove) {
-      removeState(rm);
-    }
+    keepStates(visited);
   } 
 
   void Automaton::removeNonCoAccessibleStates() {
+    std::size_t n = states->ids.size();
     std::vector<int> queue;
-    std::set<int> visited;
+    std::vector<char> visited(n, 0);
 
-    bool final = false;
-    for (auto s : states) {
-      if (isStateFinal(s.first)) {
-          queue.push_back(s.first);
-          visited.insert(s.first);
-          final = true;
+    for (std::size_t index = 0; index < n; ++index) {
+      if (isFinalAt(index)) {
+          queue.push_back(index);
+          visited[index] = 1;
       }
     }
 
-    if (!final) {
-        states.clear();
-        transitions.clear();
-        return;
+    if (reverseIndexed) {
+      while (!queue.empty()) {
+        int index = queue.back();
+        queue.pop_back();
+        for (const auto& edge : reverse[index]) {
+          if (!visited[edge.to]) {
+            queue.push_back(edge.to);
+            visited[edge.to] = 1;
+          }
+        }
+      }
+      keepStates(visited);
+      return;
     }
 
-    std::unordered_map<int, std::vector<int>> predecessors;
-    for (const auto& [from, mapChar] : transitions) {
-        for (const auto& [alpha, dests] : mapChar) {
-            for (int to : dests) {
-                predecessors[to].push_back(from);
-            }
-        }
+    // predecessors of each state, stored contiguously
+    std::vector<std::size_t> offsets(n + 1, 0);
+    for (const auto& list : edges) {
+      for (const auto& edge : list) {
+        offsets[edge.to + 1]++;
+      }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<int> predecessors(offsets[n]);
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t from = 0; from < n; ++from) {
+      for (const auto& edge : edges[from]) {
+        predecessors[fill[edge.to]++] = from;
+      }
     }
 
     while (!queue.empty()) {
-      int state = queue.back();
+      int index = queue.back();
       queue.pop_back();
       
-      if (predecessors.count(state)) {
-          for (int prev : predecessors[state]) {
-            if (visited.find(prev) == visited.end()) {
-                queue.push_back(prev);
-                visited.insert(prev);
-            }
-          }
+      for (std::size_t i = offsets[index]; i < offsets[index + 1]; ++i) {
+        int prev = predecessors[i];
+        if (!visited[prev]) {
+            queue.push_back(prev);
+            visited[prev] = 1;
+        }
       }
     }
 
-    std::vector<int> remove;
-    for (auto current : states) {
-      if (visited.find(current.first) == visited.end()) {
-        remove.push_back(current.first);
+    keepStates(visited);
+  }
+
+  void Automaton::makeProductEdges(int lhs, const Automaton& other, int rhs, ProductScratch& scratch) const {
+    auto& result = scratch.edges;
+    auto& lhsTargets = scratch.lhsTargets;
+    auto& rhsTargets = scratch.rhsTargets;
+    result.clear();
+    const auto& lhsEdges = edges[lhs];
+    const auto& rhsEdges = other.edges[rhs];
+
+    // merge-join on the symbols, the epsilon-transitions come first and are
+    // replaced by the closures of the targets
+    auto lhsIt = symbolRange(lhsEdges, fa::Epsilon).second;
+    auto rhsIt = symbolRange(rhsEdges, fa::Epsilon).second;
+    while (lhsIt != lhsEdges.end() && rhsIt != rhsEdges.end()) {
+      if (lhsIt->symbol < rhsIt->symbol) {
+        ++lhsIt;
+        continue;
       }
-    }
+      if (rhsIt->symbol < lhsIt->symbol) {
+        ++rhsIt;
+        continue;
+      }
+
+      char c = lhsIt->symbol;
+      lhsTargets.clear();
+      for (; lhsIt != lhsEdges.end() && lhsIt->symbol == c; ++lhsIt) {
+        addClosure(lhsTargets, lhsIt->to);
+      }
+      rhsTargets.clear();
+      for (; rhsIt != rhsEdges.end() && rhsIt->symbol == c; ++rhsIt) {
+        other.addClosure(rhsTargets, rhsIt->to);
+      }
+      if (epsilonCount > 0) normalize(lhsTargets);
+      if (other.epsilonCount > 0) normalize(rhsTargets);
 
-    for (auto rm : remove) {
-      removeState(rm);
+      for (int to : lhsTargets) {
+        for (int otherTo : rhsTargets) {
+          result.push_back({ c, to, otherTo });
+        }
+      }
     }
   }
 
   bool Automaton::hasEmptyIntersectionWith(const Automaton& other) const {
-    Automaton intersection = Automaton::createIntersection(*this, other);
-    return intersection.isLanguageEmpty();
+    // the product is explored depth-first and never built
+    PairTable visited(memoryResource());
+    std::pmr::vector<std::pair<int, int>> stack(memoryResource());
+    std::pmr::vector<int> otherInitials = other.initialClosure(memoryResource());
+    for (int lhs : initialClosure(memoryResource())) {
+      for (int rhs : otherInitials) {
+        if (visited.insert(lhs, rhs, 0).second) {
+          stack.push_back({ lhs, rhs });
+        }
+      }
+    }
+
+    ProductScratch next(memoryResource());
+    while (!stack.empty()) {
+      auto [lhs, rhs] = stack.back();
+      stack.pop_back();
+      if (isFinalAt(lhs) && other.isFinalAt(rhs)) return false;
+
+      makeProductEdges(lhs, other, rhs, next);
+      for (const auto& edge : next.edges) {
+        if (visited.insert(edge.lhs, edge.rhs, 0).second) {
+          stack.push_back({ edge.lhs, edge.rhs });
+        }
+      }
+    }
+
+    return true;
   }
 
   bool Automaton::isIncludedIn(const Automaton& other) const {
-    Automaton complement = Automaton::createComplement(other);
-    Automaton intersection = Automaton::createIntersection(*this, complement);
-    return intersection.isLanguageEmpty();
+    std::string counterexample;
+    return isIncludedIn(other, counterexample);
+  }
+
+  bool Automaton::isIncludedIn(const Automaton& other, std::string& counterexample) const {
+    struct Pair {
+      int state;
+      std::vector<int> set;
+      int parent;
+      char symbol;
+      bool alive;
+    };
+
+    std::vector<Pair> pairs;
+    std::vector<std::vector<int>> antichains(states->ids.size());
+
+    auto rejects = [&other](const std::vector<int>& set) {
+      for (int index : set) {
+        if (other.isFinalAt(index)) return false;
+      }
+      return true;
+    };
+
+    // Keep only the pairs with a minimal set: if a word leads to (p, S) and
+    // another one to (p, S') with S' included in S, every counterexample
+    // found from (p, S) is also found from (p, S').
+    auto insert = [&](int state, std::vector<int> set, int parent, char symbol) {
+      std::vector<int>& antichain = antichains[state];
+      for (int pair : antichain) {
+        if (std::includes(set.begin(), set.end(), pairs[pair].set.begin(), pairs[pair].set.end())) {
+          return false;
+        }
+      }
+      auto end = std::remove_if(antichain.begin(), antichain.end(), [&](int pair) {
+        if (!std::includes(pairs[pair].set.begin(), pairs[pair].set.end(), set.begin(), set.end())) {
+          return false;
+        }
+        pairs[pair].alive = false;
+        return true;
+      });
+      antichain.erase(end, antichain.end());
+      antichain.push_back(pairs.size());
+      pairs.push_back({ state, std::move(set), parent, symbol, true });
+      return true;
+    };
+
+    auto found = [&](int pair) {
+      counterexample.clear();
+      for (; pair >= 0; pair = pairs[pair].parent) {
+        if (pairs[pair].parent >= 0) {
+          counterexample.push_back(pairs[pair].symbol);
+        }
+      }
+      std::reverse(counterexample.begin(), counterexample.end());
+      return false;
+    };
+
+    std::vector<int> start = other.initialClosure();
+    for (int state : initialClosure()) {
+      insert(state, start, -1, fa::Epsilon);
+    }
+
+    // breadth-first, so the counterexample is short
+    for (std::size_t current = 0; current < pairs.size(); ++current) {
+      if (!pairs[current].alive) continue;
+      int state = pairs[current].state;
+      if (isFinalAt(state) && rejects(pairs[current].set)) {
+        return found(current);
+      }
+
+      for (char c : alphabet) {
+        std::vector<int> targets = makeClosedTransition({ state }, c);
+        if (targets.empty()) continue;
+        std::vector<int> next = other.makeClosedTransition(pairs[current].set, c);
+        for (int target : targets) {
+          insert(target, next, current, c);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool Automaton::isEquivalentTo(const Automaton& other) const {
+    std::string counterexample;
+    return isEquivalentTo(other, counterexample);
+  }
+
+  bool Automaton::isEquivalentTo(const Automaton& other, std::string& counterexample) const {
+    const Automaton* sides[2] = { this, &other };
+    std::set<char> symbols;
+    std::set_union(alphabet.begin(), alphabet.end(), other.alphabet.begin(), other.alphabet.end(),
+        std::inserter(symbols, symbols.begin()));
+
+    // Macro-states of both automata share the same numbering. A deterministic
+    // automaton has singletons (or the empty set) only, their number is found
+    // directly from the index.
+    struct Macro {
+      int side;
+      std::vector<int> set;
+      bool final;
+    };
+    std::vector<Macro> macros;
+    std::map<std::vector<int>, int> translate[2];
+    std::vector<int> direct[2];
+    bool deterministic[2];
+    for (int side = 0; side < 2; ++side) {
+      deterministic[side] = sides[side]->isDeterministic();
+      if (deterministic[side]) {
+        direct[side].assign(sides[side]->states->ids.size() + 1, -1);
+      }
+    }
+
+    std::vector<int> parents;
+    std::vector<int> sizes;
+    auto find = [&parents](int x) {
+      while (parents[x] != x) {
+        parents[x] = parents[parents[x]];
+        x = parents[x];
+      }
+      return x;
+    };
+
+    auto intern = [&](int side, std::vector<int>&& set) {
+      int* slot = nullptr;
+      if (deterministic[side]) {
+        slot = &direct[side][set.empty() ? sides[side]->states->ids.size() : set.front()];
+        if (*slot >= 0) return *slot;
+      } else {
+        auto found = translate[side].find(set);
+        if (found != translate[side].end()) return found->second;
+      }
+
+      int id = macros.size();
+      bool final = false;
+      for (int index : set) {
+        final = final || sides[side]->isFinalAt(index);
+      }
+      if (slot != nullptr) {
+        *slot = id;
+      } else {
+        translate[side].insert({ set, id });
+      }
+      macros.push_back({ side, std::move(set), final });
+      parents.push_back(id);
+      sizes.push_back(1);
+      return id;
+    };
+
+    struct Pair {
+      int lhs;
+      int rhs;
+      int parent;
+      char symbol;
+    };
+    std::vector<Pair> pairs;
+
+    auto merge = [&](int lhs, int rhs, int parent, char symbol) {
+      int x = find(lhs);
+      int y = find(rhs);
+      if (x == y) return true;
+      if (sizes[x] < sizes[y]) std::swap(x, y);
+      parents[y] = x;
+      sizes[x] += sizes[y];
+      pairs.push_back({ lhs, rhs, parent, symbol });
+      return macros[lhs].final == macros[rhs].final;
+    };
+
+    // Breadth-first: the pairs are merged by increasing length of the word
+    // leading to them, so the first pair that disagrees gives a shortest word.
+    int mismatch = -1;
+    int start = intern(0, initialClosure());
+    if (!merge(start, intern(1, other.initialClosure()), -1, fa::Epsilon)) {
+      mismatch = 0;
+    }
+    for (std::size_t current = 0; mismatch < 0 && current < pairs.size(); ++current) {
+      for (char c : symbols) {
+        int lhs = pairs[current].lhs;
+        int rhs = pairs[current].rhs;
+        int nextLhs = intern(0, makeClosedTransition(macros[lhs].set, c));
+        int nextRhs = intern(1, other.makeClosedTransition(macros[rhs].set, c));
+        if (!merge(nextLhs, nextRhs, current, c)) {
+          mismatch = pairs.size() - 1;
+          break;
+        }
+      }
+    }
+    if (mismatch < 0) return true;
+
+    counterexample.clear();
+    for (int pair = mismatch; pairs[pair].parent >= 0; pair = pairs[pair].parent) {
+      counterexample.push_back(pairs[pair].symbol);
+    }
+    std::reverse(counterexample.begin(), counterexample.end());
+    return false;
   }
 
   Automaton Automaton::createIntersection(const Automaton& lhs, const Automaton& rhs) {
-    Automaton first = lhs;
-    Automaton second = rhs;
-    Automaton final;
+    Automaton final(lhs.memoryResource());
 
     std::set_intersection(
-      first.alphabet.begin(), first.alphabet.end(),
-      second.alphabet.begin(), second.alphabet.end(),
+      lhs.alphabet.begin(), lhs.alphabet.end(),
+      rhs.alphabet.begin(), rhs.alphabet.end(),
       std::inserter(final.alphabet, final.alphabet.begin())
     );
 
-    int firstInitial = -1;
-    int secondInitial = -1;
+    // the pairs are numbered in breadth-first order, a pair's number is also
+    // its index in the product
+    PairTable translate(lhs.memoryResource());
+    std::pmr::vector<std::pair<int, int>> pairs(lhs.memoryResource());
+    auto reach = [&](int lhsIndex, int rhsIndex) {
+      auto inserted = translate.insert(lhsIndex, rhsIndex, pairs.size());
+      if (inserted.second) {
+        pairs.push_back({ lhsIndex, rhsIndex });
+        final.addState(inserted.first);
+        if (lhs.isFinalAt(lhsIndex) && rhs.isFinalAt(rhsIndex)) {
+          final.setStateFinal(inserted.first);
+        }
+      }
+      return inserted.first;
+    };
 
-    for (auto s : first.states) {
-      if (first.isStateInitial(s.first)) {
-        firstInitial = s.first;
-        break;
+    std::pmr::vector<int> rhsInitials = rhs.initialClosure(lhs.memoryResource());
+    for (int lhsIndex : lhs.initialClosure(lhs.memoryResource())) {
+      for (int rhsIndex : rhsInitials) {
+        final.setStateInitial(reach(lhsIndex, rhsIndex));
       }
     }
-    for (auto s : second.states) {
-      if (second.isStateInitial(s.first)) {
-        secondInitial = s.first;
-        break;
+
+    ProductScratch next(lhs.memoryResource());
+    for (std::size_t current = 0; current < pairs.size(); ++current) {
+      lhs.makeProductEdges(pairs[current].first, rhs, pairs[current].second, next);
+      if (next.edges.empty()) continue;
+
+      auto& list = final.edges.write(current);
+      for (const auto& edge : next.edges) {
+        int to = reach(edge.lhs, edge.rhs);
+        list.push_back({ edge.symbol, to });
       }
+
+      // the edges come grouped by symbol, the targets are sorted afterwards
+      std::sort(list.begin(), list.end());
+      list.erase(std::unique(list.begin(), list.end()), list.end());
+      final.transitionCount += list.size();
     }
+    return final;
+  }
+
+  Automaton Automaton::createDeterministic(const Automaton& other) {
+    if (other.isDeterministic()) return Automaton(other, other.memoryResource());
 
-    if (firstInitial == -1 || secondInitial == -1) {
-      return final;
+    std::pmr::memory_resource* resource = other.memoryResource();
+    Automaton fa(resource);
+    fa.alphabet = other.alphabet;
+
+    std::pmr::vector<char> symbols(other.alphabet.begin(), other.alphabet.end(), resource);
+    std::array<int, 256> columns;
+    columns.fill(-1);
+    for (std::size_t column = 0; column < symbols.size(); ++column) {
+      columns[static_cast<unsigned char>(symbols[column])] = column;
     }
 
-    int cpt = 0;
-    std::map<std::pair<int, int>, int> translate;
-    std::deque<std::pair<int, int>> queue;
-    std::pair<int, int> initial = {firstInitial, secondInitial};
-    translate[initial] = cpt;
+    SubsetPool subsets(resource);
+    auto intern = [&](const auto& set) {
+      auto interned = subsets.intern(set);
+      if (interned.second) {
+        fa.addState(interned.first);
+        for (int index : set) {
+          if (other.isFinalAt(index)) {
+            fa.setStateFinal(interned.first);
+            break;
+          }
+        }
+      }
+      return interned.first;
+    };
+
+    fa.setStateInitial(intern(other.initialClosure(resource)));
+
+    // All the successors of a macro-state are computed in one pass over the
+    // edges of its states, which are sorted by symbol. The subsets are
+    // numbered in breadth-first order.
+    std::pmr::vector<std::pmr::vector<int>> successors(symbols.size(), resource);
+    for (std::size_t current = 0; current < subsets.size(); ++current) {
+      for (const int* from = subsets.begin(current); from != subsets.end(current); ++from) {
+        for (const auto& edge : other.edges[*from]) {
+          int column = columns[static_cast<unsigned char>(edge.symbol)];
+          if (column >= 0) {
+            other.addClosure(successors[column], edge.to);
+          }
+        }
+      }
 
-    final.addState(cpt);
-    final.setStateInitial(cpt);
-    if (first.isStateFinal(firstInitial) && second.isStateFinal(secondInitial)) {
-      final.setStateFinal(cpt);
+      for (std::size_t column = 0; column < symbols.size(); ++column) {
+        std::pmr::vector<int>& next = successors[column];
+        if (next.empty()) continue;
+        normalize(next);
+        int to = intern(next);
+        fa.edges.write(current).push_back({ symbols[column], to });
+        fa.transitionCount++;
+        next.clear();
+      }
     }
-    queue.push_back(initial);
-    cpt++;
+    
+    return fa;
+  }
 
-    while (!queue.empty()) {
-      std::pair<int, int> current = queue.front();
-      queue.pop_front();
+  Automaton Automaton::createDeterministic(Automaton&& other) {
+    other.determinizeInPlace();
+    return std::move(other);
+  }
 
-      int stateA = current.first;
-      int stateB = current.second;
-      int newStart = translate[current];
+  void Automaton::determinizeInPlace() {
+    if (isDeterministic()) return;
+    // the macro-states refer to the current states, the storage is replaced
+    // once the new automaton is built
+    bool indexed = reverseIndexed;
+    *this = createDeterministic(*this);
+    setReverseIndex(indexed);
+  }
 
-      for (char c : final.alphabet) {
-        std::set<int> nextStateA = first.makeTransition({stateA}, c);
-        if (nextStateA.empty()) continue;
-        int newStateA = *nextStateA.begin();
+  Automaton Automaton::createDeterministic(const Automaton& other, unsigned threads) {
+    if (other.isDeterministic()) return Automaton(other, other.memoryResource());
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1) return createDeterministic(other);
+
+    std::size_t k = other.alphabet.size();
+    std::vector<char> symbols(other.alphabet.begin(), other.alphabet.end());
+    std::array<int, 256> columns;
+    columns.fill(-1);
+    for (std::size_t column = 0; column < k; ++column) {
+      columns[static_cast<unsigned char>(symbols[column])] = column;
+    }
 
-        std::set<int> nextStateB = second.makeTransition({stateB}, c);
-        if (nextStateB.empty()) continue;
-        int newStateB = *nextStateB.begin();
+    // The subsets are interned in shards chosen by the high bits of their
+    // hash. A subset is numbered by its shard and its number in the shard,
+    // the final numbering is done at the end. The memory resource of the
+    // automaton may not be thread-safe, the shards use the default one.
+    struct Shard {
+      std::mutex mutex;
+      SubsetPool pool;
+    };
+    std::vector<Shard> shards(Shards);
+
+    struct Discovered {
+      int id;
+      bool final;
+      std::vector<int> set;
+    };
+
+    auto intern = [&](const std::vector<int>& set, std::vector<Discovered>& found) {
+      std::uint64_t hash = SubsetPool::hashSet(set);
+      std::size_t shard = hash >> 58;
+      std::pair<int, bool> interned;
+      {
+        std::lock_guard<std::mutex> lock(shards[shard].mutex);
+        interned = shards[shard].pool.intern(set, hash);
+      }
+      int id = interned.first * Shards + shard;
+      if (interned.second) {
+        bool final = false;
+        for (int index : set) {
+          final = final || other.isFinalAt(index);
+        }
+        found.push_back({ id, final, set });
+      }
+      return id;
+    };
+
+    // the closures are computed now, before the threads share the automaton
+    std::vector<Discovered> frontier;
+    int start = intern(other.initialClosure(), frontier);
+
+    // transitions by row, a row per subset in order of discovery
+    std::vector<int> rows;
+    std::vector<char> finals;
+    std::vector<std::vector<int>> rowOf(Shards);
+
+    // The frontier is expanded level by level. The threads take chunks of
+    // the frontier, each one keeps the subsets it discovers.
+    std::vector<std::vector<Discovered>> discovered(threads);
+    std::vector<int> level;
+    while (!frontier.empty()) {
+      level.assign(frontier.size() * k, -1);
+      std::atomic<std::size_t> cursor(0);
+
+      auto expand = [&](unsigned worker) {
+        std::vector<std::vector<int>> successors(k);
+        for (;;) {
+          std::size_t first = cursor.fetch_add(FrontierChunk);
+          if (first >= frontier.size()) return;
+          std::size_t last = std::min(first + FrontierChunk, frontier.size());
+          for (std::size_t i = first; i < last; ++i) {
+            for (int from : frontier[i].set) {
+              for (const auto& edge : other.edges[from]) {
+                int column = columns[static_cast<unsigned char>(edge.symbol)];
+                if (column >= 0) {
+                  other.addClosure(successors[column], edge.to);
+                }
+              }
+            }
+            for (std::size_t column = 0; column < k; ++column) {
+              std::vector<int>& next = successors[column];
+              if (next.empty()) continue;
+              normalize(next);
+              level[i * k + column] = intern(next, discovered[worker]);
+              next.clear();
+            }
+          }
+        }
+      };
 
-        std::pair<int, int> newCouple = {newStateA, newStateB};
+      // small frontiers are not worth starting the threads
+      if (frontier.size() < ParallelFrontier) {
+        expand(0);
+      } else {
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (unsigned worker = 1; worker < threads; ++worker) {
+          pool.emplace_back(expand, worker);
+        }
+        expand(0);
+        for (auto& thread : pool) {
+          thread.join();
+        }
+      }
+
+      for (std::size_t i = 0; i < frontier.size(); ++i) {
+        std::vector<int>& shardRows = rowOf[frontier[i].id % Shards];
+        std::size_t local = frontier[i].id / Shards;
+        if (shardRows.size() <= local) {
+          shardRows.resize(local + 1, -1);
+        }
+        shardRows[local] = finals.size();
+        finals.push_back(frontier[i].final);
+      }
+      rows.insert(rows.end(), level.begin(), level.end());
 
-        if (translate.find(newCouple) == translate.end()) {
-          translate[newCouple] = cpt;
-          final.addState(cpt);
+      frontier.clear();
+      for (auto& found : discovered) {
+        std::move(found.begin(), found.end(), std::back_inserter(frontier));
+        found.clear();
+      }
+    }
 
-          if (first.isStateFinal(newStateA) && second.isStateFinal(newStateB)) final.setStateFinal(cpt);
-          
-          queue.push_back(newCouple);
-          cpt++;
+    // breadth-first renumbering, the result is the same as the sequential one
+    auto rowOfId = [&rowOf](int id) {
+      return rowOf[id % Shards][id / Shards];
+    };
+    Automaton fa(other.memoryResource());
+    fa.alphabet = other.alphabet;
+    std::vector<int> numbers(finals.size(), -1);
+    std::vector<int> queue;
+    queue.push_back(rowOfId(start));
+    numbers[queue.front()] = 0;
+    fa.addState(0);
+    fa.setStateInitial(0);
+    for (std::size_t current = 0; current < queue.size(); ++current) {
+      int row = queue[current];
+      if (finals[row]) {
+        fa.setStateFinal(current);
+      }
+      for (std::size_t column = 0; column < k; ++column) {
+        int id = rows[row * k + column];
+        if (id < 0) continue;
+        int target = rowOfId(id);
+        if (numbers[target] < 0) {
+          numbers[target] = queue.size();
+          fa.addState(queue.size());
+          queue.push_back(target);
         }
+        fa.edges.write(current).push_back({ symbols[column], numbers[target] });
+        fa.transitionCount++;
+      }
+    }
 
-        int newTarget = translate[newCouple];
-        final.addTransition(newStart, c, newTarget);
+    return fa;
+  }
+
+  bool Automaton::isClosedFinalAt(int index) const {
+    const std::pmr::vector<int>* closure = closureOf(index);
+    if (closure == nullptr) return isFinalAt(index);
+    for (int member : *closure) {
+      if (isFinalAt(member)) return true;
+    }
+    return false;
+  }
+
+  void Automaton::appendClosedEdges(int index, int offset, std::pmr::vector<Edge>& result) const {
+    auto append = [&](int member) {
+      auto first = symbolRange(edges[member], fa::Epsilon).second;
+      for (auto it = first; it != edges[member].end(); ++it) {
+        result.push_back({ it->symbol, it->to + offset });
       }
+    };
+
+    const std::pmr::vector<int>* closure = closureOf(index);
+    if (closure == nullptr) {
+      append(index);
+      return;
+    }
+    for (int member : *closure) {
+      append(member);
     }
-    return final;
   }
 
-  Automaton Automaton::createDeterministic(const Automaton& other) {
-    if (other.isDeterministic()) return other;
+  void Automaton::addDenseStates(std::size_t count) {
+    StateTable& table = states.write();
+    table.ids.resize(count);
+    std::iota(table.ids.begin(), table.ids.end(), 0);
+    table.indices.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+      table.indices.insert({ static_cast<int>(index), static_cast<int>(index) });
+    }
+    table.kinds.assign(count, NONE);
+    edges.resize(count);
+  }
 
-    Automaton fa;
-    fa.alphabet = other.alphabet;
+  void Automaton::buildReverseIndex() {
+    reverse = EdgeTable(memoryResource());
+    reverse.resize(edges.size());
+    for (std::size_t from = 0; from < edges.size(); ++from) {
+      for (const auto& edge : edges[from]) {
+        reverse.write(edge.to).push_back({ edge.symbol, static_cast<int>(from) });
+      }
+    }
+    for (std::size_t index = 0; index < reverse.size(); ++index) {
+      if (reverse[index].empty()) continue;
+      auto& list = reverse.write(index);
+      std::sort(list.begin(), list.end());
+    }
+  }
+
+  void Automaton::sortEdges() {
+    transitionCount = 0;
+    epsilonCount = 0;
+    for (std::size_t index = 0; index < edges.size(); ++index) {
+      if (edges[index].empty()) continue;
+      auto& list = edges.write(index);
+      std::sort(list.begin(), list.end());
+      list.erase(std::unique(list.begin(), list.end()), list.end());
+      transitionCount += list.size();
+      epsilonCount += symbolRange(list, fa::Epsilon).second - list.begin();
+    }
+    closures.valid = false;
+  }
+
+  Automaton Automaton::createUnion(const Automaton& lhs, const Automaton& rhs) {
+    // disjoint union: the states of rhs follow the states of lhs
+    int offset = lhs.states->ids.size();
+    Automaton fa(lhs.memoryResource());
+    std::set_union(lhs.alphabet.begin(), lhs.alphabet.end(), rhs.alphabet.begin(), rhs.alphabet.end(),
+        std::inserter(fa.alphabet, fa.alphabet.begin()));
+    fa.addDenseStates(lhs.states->ids.size() + rhs.states->ids.size());
+
+    for (int index = 0; index < offset; ++index) {
+      lhs.appendClosedEdges(index, 0, fa.edges.write(index));
+      if (lhs.isInitialAt(index)) fa.setStateInitial(index);
+      if (lhs.isClosedFinalAt(index)) fa.setStateFinal(index);
+    }
+    for (std::size_t index = 0; index < rhs.states->ids.size(); ++index) {
+      rhs.appendClosedEdges(index, offset, fa.edges.write(offset + index));
+      if (rhs.isInitialAt(index)) fa.setStateInitial(offset + index);
+      if (rhs.isClosedFinalAt(index)) fa.setStateFinal(offset + index);
+    }
+
+    fa.sortEdges();
+    return fa;
+  }
 
-    std::set<int> startSet;
-    for (auto s : other.states) {
-      if (other.isStateInitial(s.first)) {
-        startSet.insert(s.first);
+  Automaton Automaton::createConcatenation(const Automaton& lhs, const Automaton& rhs) {
+    int offset = lhs.states->ids.size();
+    Automaton fa(lhs.memoryResource());
+    std::set_union(lhs.alphabet.begin(), lhs.alphabet.end(), rhs.alphabet.begin(), rhs.alphabet.end(),
+        std::inserter(fa.alphabet, fa.alphabet.begin()));
+    fa.addDenseStates(lhs.states->ids.size() + rhs.states->ids.size());
+
+    // the edges leaving the initial states of rhs, computed once
+    std::pmr::vector<Edge> start(lhs.memoryResource());
+    bool rhsEmptyWord = false;
+    for (std::size_t index = 0; index < rhs.states->ids.size(); ++index) {
+      if (rhs.isInitialAt(index)) {
+        rhs.appendClosedEdges(index, offset, start);
+        rhsEmptyWord = rhsEmptyWord || rhs.isClosedFinalAt(index);
+      }
+    }
+    bool lhsEmptyWord = false;
+    for (int index = 0; index < offset; ++index) {
+      if (lhs.isInitialAt(index) && lhs.isClosedFinalAt(index)) {
+        lhsEmptyWord = true;
       }
     }
 
-    std::map<std::set<int>, int> translate;
-    std::deque<std::set<int>> queue;
+    // the final states of lhs continue like the initial states of rhs
+    for (int index = 0; index < offset; ++index) {
+      auto& list = fa.edges.write(index);
+      lhs.appendClosedEdges(index, 0, list);
+      if (lhs.isInitialAt(index)) fa.setStateInitial(index);
+      if (lhs.isClosedFinalAt(index)) {
+        list.insert(list.end(), start.begin(), start.end());
+        if (rhsEmptyWord) fa.setStateFinal(index);
+      }
+    }
+    for (std::size_t index = 0; index < rhs.states->ids.size(); ++index) {
+      rhs.appendClosedEdges(index, offset, fa.edges.write(offset + index));
+      if (lhsEmptyWord && rhs.isInitialAt(index)) fa.setStateInitial(offset + index);
+      if (rhs.isClosedFinalAt(index)) fa.setStateFinal(offset + index);
+    }
 
-    int cpt = 0;
-    translate[startSet] = cpt;
-    fa.addState(cpt);
-    fa.setStateInitial(cpt);
-    queue.push_back(startSet);
-
-    bool startIsFinal = false;
-    for (auto s : startSet) {
-      if (other.isStateFinal(s)) {
-        startIsFinal = true;
-        break;
+    fa.sortEdges();
+    return fa;
+  }
+
+  Automaton Automaton::createKleeneStar(const Automaton& automaton) {
+    // a new initial and final state 0 accepts the empty word, the states of
+    // the automaton follow it
+    Automaton fa(automaton.memoryResource());
+    fa.alphabet = automaton.alphabet;
+    fa.addDenseStates(automaton.states->ids.size() + 1);
+    fa.setStateInitial(0);
+    fa.setStateFinal(0);
+
+    auto& start = fa.edges.write(0);
+    for (std::size_t index = 0; index < automaton.states->ids.size(); ++index) {
+      if (automaton.isInitialAt(index)) {
+        automaton.appendClosedEdges(index, 1, start);
       }
     }
-    if (startIsFinal) {
-      fa.setStateFinal(cpt);
+    std::sort(start.begin(), start.end());
+    start.erase(std::unique(start.begin(), start.end()), start.end());
+
+    // the final states go back like the initial states
+    for (std::size_t index = 0; index < automaton.states->ids.size(); ++index) {
+      auto& list = fa.edges.write(index + 1);
+      automaton.appendClosedEdges(index, 1, list);
+      if (automaton.isClosedFinalAt(index)) {
+        fa.setStateFinal(index + 1);
+        list.insert(list.end(), start.begin(), start.end());
+      }
     }
-    cpt++;
 
-    while (!queue.empty()) {
-      std::set<int> currentSet = queue.front();
-      queue.pop_front();
-      
-      int currentState = translate[currentSet];
+    fa.sortEdges();
+    return fa;
+  }
+
+  Automaton Automaton::createFromRegex(std::string_view regex) {
+    Positions positions;
+    Fragment fragment = RegexParser(regex, positions).parse();
+
+    // the state 0 is initial, the position p is the state p + 1
+    Automaton fa;
+    std::size_t n = positions.symbols.size();
+    fa.addDenseStates(n + 1);
+    fa.setStateInitial(0);
+    if (fragment.nullable) {
+      fa.setStateFinal(0);
+    }
+    for (int position : fragment.last) {
+      fa.setStateFinal(position + 1);
+    }
+
+    auto addEdges = [&](int from, const std::vector<int>& targets) {
+      for (int position : targets) {
+        for (char c : positions.symbols[position]) {
+          fa.edges.write(from).push_back({ c, position + 1 });
+        }
+      }
+    };
+    addEdges(0, fragment.first);
+    for (std::size_t position = 0; position < n; ++position) {
+      addEdges(position + 1, positions.follow[position]);
+      fa.alphabet.insert(positions.symbols[position].begin(), positions.symbols[position].end());
+    }
 
-      for (char alpha : fa.alphabet) {
-        std::set<int> nextSet = other.makeTransition(currentSet, alpha);
+    fa.sortEdges();
+    return fa;
+  }
 
-        if (nextSet.empty()) continue;
+  Automaton::SortedWordsBuilder::SortedWordsBuilder()
+  : buckets(16, -1)
+  , registered(0)
+  , words(0)
+  {
+    path.push_back(createNode());
+  }
 
-        if (translate.find(nextSet) == translate.end()) {
-          translate[nextSet] = cpt;
-          fa.addState(cpt);
+  int Automaton::SortedWordsBuilder::createNode() {
+    if (!freeNodes.empty()) {
+      int node = freeNodes.back();
+      freeNodes.pop_back();
+      nodes[node].final = false;
+      nodes[node].edges.clear();
+      return node;
+    }
+    nodes.push_back({ false, {} });
+    return nodes.size() - 1;
+  }
 
-          bool isFinal = false;
-          for (auto s : nextSet) {
-            if (other.isStateFinal(s)) {
-              isFinal = true;
-              break;
-            }
+  std::size_t Automaton::SortedWordsBuilder::hashNode(int node) const {
+    std::uint64_t hash = 14695981039346656037ull ^ static_cast<std::uint64_t>(nodes[node].final);
+    for (const auto& edge : nodes[node].edges) {
+      hash = (hash ^ static_cast<unsigned char>(edge.symbol)) * 1099511628211ull;
+      hash = (hash ^ static_cast<std::uint32_t>(edge.to)) * 1099511628211ull;
+    }
+    return hash;
+  }
+
+  void Automaton::SortedWordsBuilder::minimizePath(std::size_t depth) {
+    // From the end of the last word, each state is replaced by an equivalent
+    // registered state, or registered itself. Its edges lead to registered
+    // states only, and its last edge is the one on the path.
+    while (path.size() > depth + 1) {
+      int node = path.back();
+      path.pop_back();
+      int parent = path.back();
+
+      std::size_t mask = buckets.size() - 1;
+      std::size_t slot = hashNode(node) & mask;
+      for (; buckets[slot] >= 0; slot = (slot + 1) & mask) {
+        int other = buckets[slot];
+        if (nodes[other].final == nodes[node].final && nodes[other].edges == nodes[node].edges) break;
+      }
+
+      if (buckets[slot] >= 0) {
+        nodes[parent].edges.back().to = buckets[slot];
+        nodes[node].edges = std::vector<Edge>();
+        freeNodes.push_back(node);
+        continue;
+      }
+
+      buckets[slot] = node;
+      if (2 * ++registered > buckets.size()) {
+        std::vector<int> old(buckets.size() * 2, -1);
+        old.swap(buckets);
+        mask = buckets.size() - 1;
+        for (int other : old) {
+          if (other < 0) continue;
+          std::size_t free = hashNode(other) & mask;
+          while (buckets[free] >= 0) {
+            free = (free + 1) & mask;
           }
-          if (isFinal) fa.setStateFinal(cpt);
-          
-          queue.push_back(nextSet);
-          cpt++;
+          buckets[free] = other;
         }
+      }
+    }
+  }
 
-        fa.addTransition(currentState, alpha, translate[nextSet]);
+  void Automaton::SortedWordsBuilder::add(std::string_view word) {
+    if (words > 0 && word <= std::string_view(previous)) {
+      if (word == previous) return;
+      throw std::invalid_argument("words are not sorted");
+    }
+    for (char c : word) {
+      if (!isgraph(c)) {
+        throw std::invalid_argument("symbol is not graphic");
       }
     }
-    
+
+    std::size_t prefix = 0;
+    while (prefix < word.size() && prefix < previous.size() && word[prefix] == previous[prefix]) {
+      ++prefix;
+    }
+    minimizePath(prefix);
+
+    for (std::size_t i = prefix; i < word.size(); ++i) {
+      int node = createNode();
+      nodes[path.back()].edges.push_back({ word[i], node });
+      path.push_back(node);
+      symbols.insert(word[i]);
+    }
+    nodes[path.back()].final = true;
+    previous.assign(word.begin(), word.end());
+    ++words;
+  }
+
+  Automaton Automaton::SortedWordsBuilder::finish() {
+    minimizePath(0);
+
+    Automaton fa;
+    fa.alphabet.insert(symbols.begin(), symbols.end());
+
+    // breadth-first numbering from the root
+    std::vector<int> numbers(nodes.size(), -1);
+    std::vector<int> queue;
+    queue.push_back(path.front());
+    numbers[queue.front()] = 0;
+    fa.addState(0);
+    fa.setStateInitial(0);
+    for (std::size_t current = 0; current < queue.size(); ++current) {
+      const Node& node = nodes[queue[current]];
+      if (node.final) {
+        fa.setStateFinal(current);
+      }
+      for (const auto& edge : node.edges) {
+        if (numbers[edge.to] < 0) {
+          numbers[edge.to] = queue.size();
+          fa.addState(queue.size());
+          queue.push_back(edge.to);
+        }
+        fa.edges.write(current).push_back({ edge.symbol, numbers[edge.to] });
+        fa.transitionCount++;
+      }
+    }
+    return fa;
+  }
+
+  Automaton Automaton::createQuotient(const Automaton& dfa, const std::vector<int>& blocks) {
+    Automaton fa(dfa.memoryResource());
+    fa.alphabet = dfa.alphabet;
+
+    int initial = -1;
+    for (std::size_t index = 0; index < dfa.states->ids.size(); ++index) {
+      if (dfa.isInitialAt(index)) {
+        initial = index;
+        break;
+      }
+    }
+
+    fa.addState(0);
+    fa.setStateInitial(0);
+    if (initial < 0 || blocks[initial] < 0) return fa;
+
+    // one representative index per block of the result
+    std::unordered_map<int, int> translate;
+    std::vector<int> representatives;
+    translate.insert({ blocks[initial], 0 });
+    representatives.push_back(initial);
+
+    for (std::size_t current = 0; current < representatives.size(); ++current) {
+      int index = representatives[current];
+      if (dfa.isFinalAt(index)) {
+        fa.setStateFinal(current);
+      }
+
+      for (const auto& edge : dfa.edges[index]) {
+        int block = blocks[edge.to];
+        if (block < 0) continue;
+
+        auto found = translate.find(block);
+        if (found == translate.end()) {
+          found = translate.insert({ block, static_cast<int>(representatives.size()) }).first;
+          fa.addState(found->second);
+          representatives.push_back(edge.to);
+        }
+        fa.addTransition(current, edge.symbol, found->second);
+      }
+    }
+
     return fa;
   }
 
   Automaton Automaton::createMinimalMoore(const Automaton& other) {
-    // TODO
-    return other;
+    // a deterministic automaton is used as is, without a copy
+    bool deterministic = other.isDeterministic();
+    Automaton determinized(other.memoryResource());
+    if (!deterministic) {
+      determinized = createDeterministic(other);
+    }
+    const Automaton& dfa = deterministic ? other : determinized;
+
+    // the index n stands for the implicit sink state of an incomplete automaton
+    int n = dfa.states->ids.size();
+    std::vector<int> blocks(n + 1);
+    for (int index = 0; index < n; ++index) {
+      blocks[index] = dfa.isFinalAt(index) ? 1 : 0;
+    }
+    blocks[n] = 0;
+
+    std::vector<int> targets((n + 1) * dfa.alphabet.size(), n);
+    for (int index = 0; index < n; ++index) {
+      std::size_t column = 0;
+      for (char c : dfa.alphabet) {
+        auto range = symbolRange(dfa.edges[index], c);
+        if (range.first != range.second) {
+          targets[index * dfa.alphabet.size() + column] = range.first->to;
+        }
+        ++column;
+      }
+    }
+
+    // refine until the number of classes does not grow anymore
+    std::size_t count = 0;
+    for (;;) {
+      std::map<std::vector<int>, int> classes;
+      std::vector<int> refined(n + 1);
+      std::vector<int> signature;
+      for (int index = 0; index <= n; ++index) {
+        signature.assign(1, blocks[index]);
+        for (std::size_t column = 0; column < dfa.alphabet.size(); ++column) {
+          signature.push_back(blocks[targets[index * dfa.alphabet.size() + column]]);
+        }
+        refined[index] = classes.insert({ signature, static_cast<int>(classes.size()) }).first->second;
+      }
+      blocks.swap(refined);
+      if (classes.size() == count) break;
+      count = classes.size();
+    }
+
+    int sink = blocks[n];
+    for (int& block : blocks) {
+      if (block == sink) block = -1;
+    }
+    return createQuotient(dfa, blocks);
+  }
+
+  Automaton Automaton::createMinimalHopcroft(const Automaton& other) {
+    bool deterministic = other.isDeterministic();
+    Automaton determinized(other.memoryResource());
+    if (!deterministic) {
+      determinized = createDeterministic(other);
+    }
+    const Automaton& dfa = deterministic ? other : determinized;
+
+    // the index n stands for the implicit sink state of an incomplete automaton
+    int n = dfa.states->ids.size();
+    std::size_t k = dfa.alphabet.size();
+    std::size_t size = n + 1;
+
+    // predecessors by symbol and target, stored contiguously
+    std::vector<int> targets(size * k, n);
+    for (int index = 0; index < n; ++index) {
+      std::size_t column = 0;
+      for (char c : dfa.alphabet) {
+        auto range = symbolRange(dfa.edges[index], c);
+        if (range.first != range.second) {
+          targets[index * k + column] = range.first->to;
+        }
+        ++column;
+      }
+    }
+    std::vector<std::size_t> offsets(size * k + 1, 0);
+    for (std::size_t from = 0; from < size; ++from) {
+      for (std::size_t column = 0; column < k; ++column) {
+        offsets[column * size + targets[from * k + column] + 1]++;
+      }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<int> predecessors(offsets.back());
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t from = 0; from < size; ++from) {
+      for (std::size_t column = 0; column < k; ++column) {
+        predecessors[fill[column * size + targets[from * k + column]]++] = from;
+      }
+    }
+
+    // Refinable partition: the elements of a block are contiguous in
+    // `elements`, the marked ones are moved at the front of their block.
+    std::vector<int> elements(size);
+    std::vector<int> location(size);
+    std::vector<int> blocks(size);
+    std::vector<std::size_t> first;
+    std::vector<std::size_t> marked;
+    std::vector<std::size_t> last;
+
+    std::size_t finals = 0;
+    for (int index = 0; index < n; ++index) {
+      if (dfa.isFinalAt(index)) {
+        elements[finals++] = index;
+      }
+    }
+    std::size_t position = finals;
+    for (std::size_t index = 0; index < size; ++index) {
+      if (index == static_cast<std::size_t>(n) || !dfa.isFinalAt(index)) {
+        elements[position++] = index;
+      }
+    }
+    if (finals > 0) {
+      first.push_back(0);
+      last.push_back(finals);
+    }
+    if (finals < size) {
+      first.push_back(finals);
+      last.push_back(size);
+    }
+    marked = first;
+    for (std::size_t block = 0; block < first.size(); ++block) {
+      for (std::size_t i = first[block]; i < last[block]; ++i) {
+        location[elements[i]] = i;
+        blocks[elements[i]] = block;
+      }
+    }
+
+    // Pending splitters, as (block, symbol) pairs. With two initial blocks,
+    // only the smallest one is needed.
+    std::vector<std::pair<int, std::size_t>> pending;
+    std::vector<char> waiting(first.size() * k, 0);
+    if (first.size() == 2) {
+      int smallest = (last[0] - first[0] <= last[1] - first[1]) ? 0 : 1;
+      for (std::size_t column = 0; column < k; ++column) {
+        pending.push_back({ smallest, column });
+        waiting[smallest * k + column] = 1;
+      }
+    }
+
+    std::vector<int> splitter;
+    std::vector<int> touched;
+    while (!pending.empty()) {
+      auto [block, column] = pending.back();
+      pending.pop_back();
+      waiting[block * k + column] = 0;
+
+      // the splitter may itself be reordered while marking
+      splitter.assign(elements.begin() + first[block], elements.begin() + last[block]);
+      for (int target : splitter) {
+        std::size_t key = column * size + target;
+        for (std::size_t i = offsets[key]; i < offsets[key + 1]; ++i) {
+          int state = predecessors[i];
+          int from = blocks[state];
+          std::size_t slot = marked[from];
+          if (static_cast<std::size_t>(location[state]) < slot) continue;
+
+          int other = elements[slot];
+          elements[slot] = state;
+          elements[location[state]] = other;
+          location[other] = location[state];
+          location[state] = slot;
+          if (marked[from]++ == first[from]) {
+            touched.push_back(from);
+          }
+        }
+      }
+
+      for (int from : touched) {
+        if (marked[from] == last[from]) {
+          marked[from] = first[from];
+          continue;
+        }
+
+        // the marked part becomes a new block
+        int created = first.size();
+        first.push_back(first[from]);
+        last.push_back(marked[from]);
+        marked.push_back(first[from]);
+        first[from] = marked[from];
+        for (std::size_t i = first[created]; i < last[created]; ++i) {
+          blocks[elements[i]] = created;
+        }
+        waiting.resize(first.size() * k, 0);
+
+        std::size_t createdSize = last[created] - first[created];
+        std::size_t fromSize = last[from] - first[from];
+        for (std::size_t c = 0; c < k; ++c) {
+          int next = created;
+          if (!waiting[from * k + c] && fromSize < createdSize) {
+            next = from;
+          }
+          pending.push_back({ next, c });
+          waiting[next * k + c] = 1;
+        }
+      }
+      touched.clear();
+    }
+
+    int sink = blocks[n];
+    for (int& block : blocks) {
+      if (block == sink) block = -1;
+    }
+    return createQuotient(dfa, blocks);
   }
 
   Automaton Automaton::createMinimalBrzozowski(const Automaton& other) {
-    // TODO
-    return other;
+    BrzozowskiStats stats;
+    return createMinimalBrzozowski(other, stats);
+  }
+
+  Automaton Automaton::createMinimalBrzozowski(const Automaton& other, BrzozowskiStats& stats) {
+    stats = BrzozowskiStats();
+    std::size_t k = other.alphabet.size();
+    std::vector<char> symbols(other.alphabet.begin(), other.alphabet.end());
+
+    // first pass: the epsilon-transitions are removed by closing the targets,
+    // then the transitions are reversed
+    std::size_t n = other.states->ids.size();
+    ReverseIndex reverse(n, k);
+    std::vector<int> closed;
+    for (std::size_t from = 0; from < n; ++from) {
+      for (std::size_t column = 0; column < k; ++column) {
+        auto range = symbolRange(other.edges[from], symbols[column]);
+        closed.clear();
+        for (auto it = range.first; it != range.second; ++it) {
+          other.addClosure(closed, it->to);
+        }
+        normalize(closed);
+        for (int to : closed) {
+          reverse.add(column, to, from);
+        }
+      }
+    }
+    reverse.build();
+
+    std::vector<char> initial(n, 0);
+    for (int index : other.initialClosure()) {
+      initial[index] = 1;
+    }
+    std::vector<int> finals;
+    for (std::size_t index = 0; index < n; ++index) {
+      if (other.isFinalAt(index)) {
+        finals.push_back(index);
+      }
+    }
+
+    SubsetTable first = determinizeReverse(reverse, finals, initial, stats.largestSubset);
+    std::size_t m = first.finals.size();
+    stats.intermediateStates = m;
+    stats.intermediateTransitions = m * k - std::count(first.table.begin(), first.table.end(), -1);
+
+    // second pass: the intermediate automaton is already deterministic and
+    // epsilon-free, its start state is 0
+    ReverseIndex mirror(m, k);
+    for (std::size_t from = 0; from < m; ++from) {
+      for (std::size_t column = 0; column < k; ++column) {
+        int to = first.table[from * k + column];
+        if (to >= 0) {
+          mirror.add(column, to, from);
+        }
+      }
+    }
+    mirror.build();
+    first.table = std::vector<int>();
+
+    std::vector<char> start(m, 0);
+    start[0] = 1;
+    std::vector<int> accepting;
+    for (std::size_t index = 0; index < m; ++index) {
+      if (first.finals[index]) {
+        accepting.push_back(index);
+      }
+    }
+
+    SubsetTable last = determinizeReverse(mirror, accepting, start, stats.largestSubset);
+
+    Automaton fa(other.memoryResource());
+    fa.alphabet = other.alphabet;
+    for (std::size_t state = 0; state < last.finals.size(); ++state) {
+      fa.addState(state);
+      if (last.finals[state]) {
+        fa.setStateFinal(state);
+      }
+    }
+    fa.setStateInitial(0);
+    for (std::size_t state = 0; state < last.finals.size(); ++state) {
+      for (std::size_t column = 0; column < k; ++column) {
+        int to = last.table[state * k + column];
+        if (to >= 0) {
+          fa.addTransition(state, symbols[column], to);
+        }
+      }
+    }
+    return fa;
   }
 }
\ No newline at end of file
@@ -1,15 +1,21 @@
 #ifndef AUTOMATON_H
 #define AUTOMATON_H
 
+#include <atomic>
 #include <cstddef>
 #include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <set>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <tuple>
 #include <map>
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
 namespace fa {
 
@@ -24,6 +30,42 @@ namespace fa {
      */
     Automaton();
 
+    /**
+     * Build an empty automaton whose internal containers allocate from a
+     * memory resource. The automata created from it by the operations below
+     * use the same resource, which must outlive them.
+     *
+     * The temporaries of createDeterministic, createIntersection and
+     * hasEmptyIntersectionWith come from the resource too, except the
+     * buffers of the worker threads of the parallel createDeterministic,
+     * since a memory resource is not thread-safe in general. The other
+     * operations use the global heap for their temporaries.
+     */
+    explicit Automaton(std::pmr::memory_resource* resource);
+
+    /**
+     * Copy an automaton into another memory resource. A plain copy uses the
+     * default memory resource.
+     *
+     * The states and the transitions are shared copy-on-write by the copies
+     * using the same memory resource: a copy takes constant time, and a
+     * modification clones the state table and the edges of the modified
+     * states only.
+     */
+    Automaton(const Automaton& other, std::pmr::memory_resource* resource);
+
+    Automaton(const Automaton& other) = default;
+    Automaton(Automaton&& other) = default;
+    Automaton& operator=(const Automaton& other) = default;
+    Automaton& operator=(Automaton&& other) = default;
+
+    /**
+     * Get the memory resource of the internal containers
+     */
+    std::pmr::memory_resource* memoryResource() const {
+      return alphabet.get_allocator().resource();
+    }
+
     /**
      * Tell if an automaton is valid.
      *
@@ -127,6 +169,22 @@ namespace fa {
      */
     std::size_t countTransitions() const;
 
+    /**
+     * Keep the incoming transitions of every state up to date.
+     *
+     * Removing a state then only visits the transitions of the state and of
+     * its neighbours, and the backward search of the co-accessible states
+     * needs no preparation. The index takes as much memory as the
+     * transitions. It is disabled by default, and kept by the operations
+     * modifying the automaton in place.
+     */
+    void setReverseIndex(bool enabled);
+
+    /**
+     * Tell if the incoming transitions are indexed
+     */
+    bool hasReverseIndex() const;
+
     /**
      * Print the automaton in a friendly way
      */
@@ -154,6 +212,8 @@ namespace fa {
 
     /**
      * Make a transition from a set of states with a character.
+     *
+     * Epsilon-transitions are followed before and after reading the character.
      */
     std::set<int>makeTransition(const std::set<int>& origin, char alpha) const;
     
@@ -190,50 +250,612 @@ namespace fa {
     /**
      * Tell if the langage accepted by the automaton is included in the
      * language accepted by the other automaton
+     *
+     * The pairs of a state and a set of states of the other automaton are
+     * explored on the fly, and a pair is dropped when a pair with the same
+     * state and a smaller set was already found (antichain).
      */
     bool isIncludedIn(const Automaton& other) const;
 
+    /**
+     * Same as above, and when the language is not included, give a word that
+     * is accepted by the automaton but not by the other automaton
+     */
+    bool isIncludedIn(const Automaton& other, std::string& counterexample) const;
+
+    /**
+     * Tell if the automaton accepts the same language as the other automaton
+     *
+     * The two automata are determinized on the fly, and the pairs of states
+     * that must be equivalent are merged with a union-find (Hopcroft-Karp).
+     */
+    bool isEquivalentTo(const Automaton& other) const;
+
+    /**
+     * Same as above, and when the languages differ, give a shortest word
+     * accepted by only one of the automata
+     */
+    bool isEquivalentTo(const Automaton& other, std::string& counterexample) const;
+
     /**
      * Create a mirror automaton
      */
     static Automaton createMirror(const Automaton& automaton);
 
+    static Automaton createMirror(Automaton&& automaton);
+
     /**
      * Create a complete automaton, if not already complete
      */
     static Automaton createComplete(const Automaton& automaton);
 
+    static Automaton createComplete(Automaton&& automaton);
+
+    /**
+     * Make the automaton complete, if not already complete, by adding a sink
+     * state
+     */
+    void makeComplete();
+
     /**
      * Create a complement automaton
      */
     static Automaton createComplement(const Automaton& automaton);
 
+    static Automaton createComplement(Automaton&& automaton);
+
+    /**
+     * Make the automaton accept the complement of its language
+     */
+    void complementInPlace();
+
     /**
      * Create the intersection of the languages of two automata
      */
     static Automaton createIntersection(const Automaton& lhs, const Automaton& rhs);
 
+    /**
+     * Create the union of the languages of two automata
+     */
+    static Automaton createUnion(const Automaton& lhs, const Automaton& rhs);
+
+    /**
+     * Create the concatenation of the languages of two automata
+     */
+    static Automaton createConcatenation(const Automaton& lhs, const Automaton& rhs);
+
+    /**
+     * Create the Kleene star of the language of an automaton
+     */
+    static Automaton createKleeneStar(const Automaton& automaton);
+
     /**
      * Create a deterministic automaton, if not already deterministic
      */
     static Automaton createDeterministic(const Automaton& other);
 
+    static Automaton createDeterministic(Automaton&& other);
+
+    /**
+     * Make the automaton deterministic, if not already deterministic
+     */
+    void determinizeInPlace();
+
+    /**
+     * Create a deterministic automaton with several threads (0 for the number
+     * of hardware threads, including the calling thread)
+     *
+     * The states are numbered as in the sequential version.
+     */
+    static Automaton createDeterministic(const Automaton& other, unsigned threads);
+
     /**
      * Create an equivalent minimal automaton with the Moore algorithm
      */
     static Automaton createMinimalMoore(const Automaton& other);
 
+    /**
+     * Create an equivalent minimal automaton with the Hopcroft algorithm
+     *
+     * The automaton does not need to be complete: the missing transitions go
+     * to an implicit sink state, which is not part of the result.
+     */
+    static Automaton createMinimalHopcroft(const Automaton& other);
+
+    /**
+     * Sizes reached while minimizing with the Brzozowski algorithm
+     */
+    struct BrzozowskiStats {
+      std::size_t intermediateStates = 0;
+      std::size_t intermediateTransitions = 0;
+      std::size_t largestSubset = 0;
+    };
+
     /**
      * Create an equivalent minimal automaton with the Brzozowski algorithm
+     *
+     * The two reversals are done on the fly inside the subset constructions,
+     * only the intermediate deterministic automaton is built.
      */
     static Automaton createMinimalBrzozowski(const Automaton& other);
 
+    static Automaton createMinimalBrzozowski(const Automaton& other, BrzozowskiStats& stats);
+
+    /**
+     * Create the minimal deterministic automaton accepting a list of words
+     * sorted in increasing order
+     *
+     * The automaton is minimized while the words are added (Daciuk et al.),
+     * so it never holds more than the minimal automaton and the last word.
+     * Throws std::invalid_argument if the words are not sorted or contain a
+     * symbol that is not graphic.
+     */
+    template<typename Range>
+    static Automaton createFromSortedWords(const Range& words) {
+      SortedWordsBuilder builder;
+      for (const auto& word : words) {
+        builder.add(word);
+      }
+      return builder.finish();
+    }
+
+    /**
+     * Create the Glushkov automaton of a regular expression: one state per
+     * symbol position plus an initial state, without epsilon-transitions.
+     *
+     * Syntax, by increasing precedence:
+     *   e|f       alternation (an empty side is the empty word)
+     *   ef        concatenation
+     *   e* e+ e?  repetitions
+     *   (e)       grouping, () is the empty word
+     *   [abx-z]   one symbol of a class, with ranges (no negation)
+     *   \c        the symbol c, for one of | * + ? ( ) [ ] \ -
+     * Any other graphic character is a symbol. Throws std::invalid_argument
+     * if the expression is malformed.
+     */
+    static Automaton createFromRegex(std::string_view regex);
 
   private:
+    friend class AutomatonBuilder;
+    friend class CompiledAutomaton;
+
     enum STATE { NONE, INITIAL, FINAL, BOTH };
-    std::set<char> alphabet;
-    std::map<int, STATE> states;
-    std::unordered_map<int, std::map<char, std::set<int>>> transitions; 
+
+    /**
+     * Transition to a state given by its dense index.
+     *
+     * The edges of a state are kept sorted by symbol, then by target, so
+     * epsilon-transitions come first.
+     */
+    struct Edge {
+      char symbol;
+      int to;
+
+      bool operator<(const Edge& other) const {
+        return symbol < other.symbol || (symbol == other.symbol && to < other.to);
+      }
+
+      bool operator==(const Edge& other) const {
+        return symbol == other.symbol && to == other.to;
+      }
+    };
+
+    /**
+     * Epsilon-closures of the states involved in an epsilon-transition.
+     *
+     * The states of a strongly connected component of the epsilon-transitions
+     * share the same closure, stored once as a sorted vector of indices.
+     */
+    struct EpsilonClosures {
+      using allocator_type = std::pmr::polymorphic_allocator<int>;
+
+      explicit EpsilonClosures(const allocator_type& allocator)
+      : component(allocator)
+      , sets(allocator)
+      {
+      }
+
+      EpsilonClosures(const EpsilonClosures& other, const allocator_type& allocator)
+      : component(other.component, allocator)
+      , sets(other.sets, allocator)
+      {
+      }
+
+      std::pmr::vector<int> component;
+      std::pmr::vector<std::pmr::vector<int>> sets;
+    };
+
+    /**
+     * States of an automaton: the id and the kind of each dense index.
+     */
+    struct StateTable {
+      using allocator_type = std::pmr::polymorphic_allocator<int>;
+
+      explicit StateTable(const allocator_type& allocator)
+      : ids(allocator)
+      , indices(allocator)
+      , kinds(allocator)
+      {
+      }
+
+      StateTable(const StateTable& other, const allocator_type& allocator)
+      : ids(other.ids, allocator)
+      , indices(other.indices, allocator)
+      , kinds(other.kinds, allocator)
+      {
+      }
+
+      std::pmr::vector<int> ids;
+      std::pmr::unordered_map<int, int> indices;
+      std::pmr::vector<STATE> kinds;
+    };
+
+    /**
+     * Value shared by the copies of an automaton, cloned on the first
+     * modification. The value is only shared by the copies allocating from
+     * the same memory resource. A missing value stands for an empty one.
+     *
+     * Copies can be destroyed in other threads while one of them is being
+     * modified: the modification only happens in place when the other copies
+     * are gone, after an acquire fence.
+     */
+    template<typename T>
+    class CopyOnWrite {
+    public:
+      explicit CopyOnWrite(std::pmr::memory_resource* resource)
+      : memory(resource)
+      {
+      }
+
+      CopyOnWrite(const CopyOnWrite& other, std::pmr::memory_resource* resource)
+      : memory(resource)
+      , value(other.share(resource))
+      {
+      }
+
+      CopyOnWrite(const CopyOnWrite& other)
+      : CopyOnWrite(other, std::pmr::get_default_resource())
+      {
+      }
+
+      CopyOnWrite(CopyOnWrite&& other) = default;
+
+      CopyOnWrite& operator=(const CopyOnWrite& other) {
+        if (this != &other) {
+          value = other.share(memory);
+        }
+        return *this;
+      }
+
+      CopyOnWrite& operator=(CopyOnWrite&& other) {
+        if (*memory == *other.memory) {
+          value = std::move(other.value);
+        } else {
+          value = other.share(memory);
+        }
+        return *this;
+      }
+
+      const T& operator*() const {
+        return value ? *value : empty();
+      }
+
+      const T* operator->() const {
+        return &**this;
+      }
+
+      /**
+       * Get the value for a modification, cloned first if it is shared.
+       */
+      T& write() {
+        if (!value) {
+          value = std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(memory));
+        } else if (value.use_count() > 1) {
+          value = std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(memory), *value);
+        } else {
+          // the count is read relaxed: the release of the other copies, maybe
+          // in other threads, must happen before the modification
+          std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *value;
+      }
+
+      void reset() {
+        value.reset();
+      }
+
+      std::pmr::memory_resource* resource() const {
+        return memory;
+      }
+
+    private:
+      std::shared_ptr<T> share(std::pmr::memory_resource* resource) const {
+        if (!value || *resource == *memory) return value;
+        return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource), *value);
+      }
+
+      static const T& empty() {
+        static const T instance{ typename T::allocator_type(std::pmr::null_memory_resource()) };
+        return instance;
+      }
+
+      std::pmr::memory_resource* memory;
+      std::shared_ptr<T> value;
+    };
+
+    /**
+     * Epsilon-closures computed on first use after a modification. The
+     * computation and the copies are guarded by a mutex, so that the const
+     * operations can be called from several threads.
+     */
+    struct ClosureCache {
+      explicit ClosureCache(std::pmr::memory_resource* resource);
+      ClosureCache(const ClosureCache& other, std::pmr::memory_resource* resource);
+      ClosureCache(const ClosureCache& other);
+      ClosureCache(ClosureCache&& other) noexcept;
+      ClosureCache& operator=(const ClosureCache& other);
+      ClosureCache& operator=(ClosureCache&& other) noexcept;
+
+      CopyOnWrite<EpsilonClosures> table;
+      std::atomic<bool> valid;
+      mutable std::mutex mutex;
+    };
+
+    /**
+     * Edges of the states, by dense index. The table and each edge list are
+     * shared copy-on-write, so modifying a copy clones the lists of the
+     * modified states only. A missing list stands for an empty one.
+     */
+    class EdgeTable {
+    public:
+      using List = std::pmr::vector<Edge>;
+      using Rows = std::pmr::vector<std::shared_ptr<List>>;
+
+      class const_iterator {
+      public:
+        explicit const_iterator(Rows::const_iterator it)
+        : it(it)
+        {
+        }
+
+        const List& operator*() const {
+          return *it ? **it : emptyList();
+        }
+
+        const_iterator& operator++() {
+          ++it;
+          return *this;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+          return it != other.it;
+        }
+
+      private:
+        Rows::const_iterator it;
+      };
+
+      explicit EdgeTable(std::pmr::memory_resource* resource);
+      EdgeTable(const EdgeTable& other, std::pmr::memory_resource* resource);
+      EdgeTable(const EdgeTable& other);
+      EdgeTable(EdgeTable&& other) = default;
+      EdgeTable& operator=(const EdgeTable& other);
+      EdgeTable& operator=(EdgeTable&& other);
+
+      std::size_t size() const {
+        return rows->size();
+      }
+
+      const List& operator[](std::size_t index) const {
+        const std::shared_ptr<List>& row = (*rows)[index];
+        return row ? *row : emptyList();
+      }
+
+      const_iterator begin() const {
+        return const_iterator(rows->begin());
+      }
+
+      const_iterator end() const {
+        return const_iterator(rows->end());
+      }
+
+      /**
+       * Get the edges of a state for a modification, cloned first if they
+       * are shared.
+       */
+      List& write(std::size_t index);
+
+      void resize(std::size_t count);
+      void emplace_back();
+      void pop_back();
+
+      /**
+       * Move the edges of a state to another index, the state is left without edges.
+       */
+      void move(std::size_t to, std::size_t from);
+
+      /**
+       * Remove all the edges of a state
+       */
+      void clear(std::size_t index);
+
+    private:
+      static const List& emptyList();
+
+      void detachLists();
+
+      CopyOnWrite<Rows> rows;
+    };
+
+    /**
+     * Build the quotient of a deterministic automaton by a partition of its
+     * indices, given by a block number per index (-1 for the states to drop).
+     * The states are numbered in breadth-first order from the initial state.
+     */
+    static Automaton createQuotient(const Automaton& dfa, const std::vector<int>& blocks);
+
+    /**
+     * Get the dense index of a state, or -1 if the state does not exist.
+     */
+    int indexOf(int state) const;
+
+    bool isInitialAt(int index) const {
+      STATE kind = states->kinds[index];
+      return kind == INITIAL || kind == BOTH;
+    }
+
+    bool isFinalAt(int index) const {
+      STATE kind = states->kinds[index];
+      return kind == FINAL || kind == BOTH;
+    }
+
+    /**
+     * Tell if a state reaches a final state with epsilon-transitions only
+     */
+    bool isClosedFinalAt(int index) const;
+
+    /**
+     * Add the edges of a state once the epsilon-transitions are removed: the
+     * edges of all the states of its epsilon-closure. The targets are shifted
+     * by an offset.
+     */
+    void appendClosedEdges(int index, int offset, std::pmr::vector<Edge>& result) const;
+
+    /**
+     * Add the states numbered from 0 to count - 1 to an empty automaton.
+     */
+    void addDenseStates(std::size_t count);
+
+    /**
+     * Sort the edges of every state, remove the duplicates and count them.
+     */
+    void sortEdges();
+
+    /**
+     * Compute the incoming edges of every state from the outgoing ones.
+     */
+    void buildReverseIndex();
+
+    /**
+     * Keep only the states whose index is marked, in one pass.
+     */
+    void keepStates(const std::vector<char>& keep);
+
+    /**
+     * Get the epsilon-closures, computed on first use after a modification.
+     */
+    const EpsilonClosures& epsilonClosures() const;
+
+    /**
+     * Get the epsilon-closure of a state, or nullptr if it is the state alone.
+     */
+    const std::pmr::vector<int>* closureOf(int index) const;
+
+    /**
+     * Add the epsilon-closure of a state to a set of indices, unsorted.
+     */
+    template<typename Set>
+    void addClosure(Set& set, int index) const {
+      const std::pmr::vector<int>* closure = closureOf(index);
+      if (closure == nullptr) {
+        set.push_back(index);
+      } else {
+        set.insert(set.end(), closure->begin(), closure->end());
+      }
+    }
+
+    /**
+     * Compute the epsilon-closed set of initial states, as sorted indices.
+     */
+    std::vector<int> initialClosure() const;
+
+    /**
+     * Compute the epsilon-closed set of initial states in a memory resource.
+     */
+    std::pmr::vector<int> initialClosure(std::pmr::memory_resource* resource) const;
+
+    /**
+     * Make a transition from an epsilon-closed set of sorted indices.
+     */
+    std::vector<int> makeClosedTransition(const std::vector<int>& origin, char alpha) const;
+
+    /**
+     * Read the string and compute the set of indices after traversing the automaton
+     */
+    std::vector<int> readIndices(const std::string& word) const;
+
+    /**
+     * Incremental construction of a minimal acyclic automaton. The states of
+     * the last word are not minimized yet, the other ones are kept in a
+     * register to find the equivalent states.
+     */
+    class SortedWordsBuilder {
+    public:
+      SortedWordsBuilder();
+
+      void add(std::string_view word);
+
+      Automaton finish();
+
+    private:
+      struct Node {
+        bool final;
+        std::vector<Edge> edges;
+      };
+
+      int createNode();
+      std::size_t hashNode(int node) const;
+      void minimizePath(std::size_t depth);
+
+      std::vector<Node> nodes;
+      std::vector<int> freeNodes;
+      std::vector<int> buckets;
+      std::size_t registered;
+      std::vector<int> path;
+      std::string previous;
+      std::size_t words;
+      std::set<char> symbols;
+    };
+
+    /**
+     * Transition of the product of two automata
+     */
+    struct ProductEdge {
+      char symbol;
+      int lhs;
+      int rhs;
+    };
+
+    /**
+     * Buffers of the transitions of the product, reused from pair to pair
+     */
+    struct ProductScratch {
+      explicit ProductScratch(std::pmr::memory_resource* resource)
+      : edges(resource)
+      , lhsTargets(resource)
+      , rhsTargets(resource)
+      {
+      }
+
+      std::pmr::vector<ProductEdge> edges;
+      std::pmr::vector<int> lhsTargets;
+      std::pmr::vector<int> rhsTargets;
+    };
+
+    /**
+     * Compute the transitions from a pair of states of the product with the
+     * other automaton into scratch.edges, the targets are epsilon-closed.
+     */
+    void makeProductEdges(int lhs, const Automaton& other, int rhs, ProductScratch& scratch) const;
+
+    std::pmr::set<char> alphabet;
+    CopyOnWrite<StateTable> states;
+    EdgeTable edges;
+    EdgeTable reverse;
+    bool reverseIndexed = false;
+    std::size_t transitionCount = 0;
+    std::size_t epsilonCount = 0;
+    mutable ClosureCache closures;
   };
 }
 
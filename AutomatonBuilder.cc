@@ -0,0 +1,163 @@
+#include "AutomatonBuilder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace fa {
+
+  namespace {
+
+    void checkState(int state) {
+      if (state < 0) {
+        throw std::invalid_argument("state is negative");
+      }
+    }
+
+    void checkSymbol(char symbol) {
+      if (symbol != fa::Epsilon && !std::isgraph(static_cast<unsigned char>(symbol))) {
+        throw std::invalid_argument("symbol is not graphic");
+      }
+    }
+
+  }
+
+  AutomatonBuilder::AutomatonBuilder(std::pmr::memory_resource* resource)
+  : resource(resource)
+  {
+    symbols.fill(false);
+  }
+
+  void AutomatonBuilder::reserve(std::size_t states, std::size_t transitions) {
+    this->states.reserve(states);
+    this->transitions.reserve(transitions);
+  }
+
+  void AutomatonBuilder::addSymbol(char symbol) {
+    if (!std::isgraph(static_cast<unsigned char>(symbol))) {
+      throw std::invalid_argument("symbol is not graphic");
+    }
+    symbols[static_cast<unsigned char>(symbol)] = true;
+  }
+
+  void AutomatonBuilder::addState(int state) {
+    checkState(state);
+    states.push_back(state);
+  }
+
+  void AutomatonBuilder::setStateInitial(int state) {
+    checkState(state);
+    initials.push_back(state);
+  }
+
+  void AutomatonBuilder::setStateFinal(int state) {
+    checkState(state);
+    finals.push_back(state);
+  }
+
+  void AutomatonBuilder::addTransition(int from, char alpha, int to) {
+    Transition transition = { from, alpha, to };
+    addTransitions(&transition, 1);
+  }
+
+  void AutomatonBuilder::addTransitions(const Transition* transitions, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      checkState(transitions[i].from);
+      checkSymbol(transitions[i].symbol);
+      checkState(transitions[i].to);
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      symbols[static_cast<unsigned char>(transitions[i].symbol)] = true;
+    }
+    this->transitions.insert(this->transitions.end(), transitions, transitions + count);
+  }
+
+  Automaton AutomatonBuilder::build() {
+    // the ids are numbered with a direct table when they are small enough
+    // compared to their number, and by sorting them otherwise
+    std::size_t mentions = states.size() + initials.size() + finals.size() + 2 * transitions.size();
+    int maxId = -1;
+    auto forEachId = [this](auto&& f) {
+      for (int id : states) f(id);
+      for (int id : initials) f(id);
+      for (int id : finals) f(id);
+      for (const auto& transition : transitions) {
+        f(transition.from);
+        f(transition.to);
+      }
+    };
+    forEachId([&maxId](int id) { maxId = std::max(maxId, id); });
+
+    std::vector<int> ids;
+    std::vector<int> direct;
+    if (static_cast<std::size_t>(maxId) + 1 <= 2 * mentions + 64) {
+      direct.assign(maxId + 1, -1);
+      forEachId([&direct](int id) { direct[id] = 0; });
+      for (int id = 0; id <= maxId; ++id) {
+        if (direct[id] == 0) {
+          direct[id] = static_cast<int>(ids.size());
+          ids.push_back(id);
+        }
+      }
+    } else {
+      ids.reserve(mentions);
+      forEachId([&ids](int id) { ids.push_back(id); });
+      std::sort(ids.begin(), ids.end());
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+    auto indexOf = [&ids, &direct](int id) {
+      if (!direct.empty()) return direct[id];
+      return static_cast<int>(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin());
+    };
+
+    Automaton fa(resource);
+    for (std::size_t symbol = 0; symbol < symbols.size(); ++symbol) {
+      if (symbols[symbol] && symbol != static_cast<unsigned char>(fa::Epsilon)) {
+        fa.alphabet.insert(static_cast<char>(symbol));
+      }
+    }
+
+    std::size_t n = ids.size();
+    auto& table = fa.states.write();
+    table.ids.assign(ids.begin(), ids.end());
+    table.indices.reserve(n);
+    for (std::size_t index = 0; index < n; ++index) {
+      table.indices.insert({ ids[index], static_cast<int>(index) });
+    }
+    table.kinds.assign(n, Automaton::NONE);
+    for (int id : initials) {
+      table.kinds[indexOf(id)] = Automaton::INITIAL;
+    }
+    for (int id : finals) {
+      auto& kind = table.kinds[indexOf(id)];
+      kind = (kind == Automaton::INITIAL || kind == Automaton::BOTH) ? Automaton::BOTH : Automaton::FINAL;
+    }
+
+    // the transitions are distributed to their source, then every list is
+    // sorted and deduplicated on its own
+    std::vector<std::size_t> degrees(n, 0);
+    for (auto& transition : transitions) {
+      transition.from = indexOf(transition.from);
+      transition.to = indexOf(transition.to);
+      ++degrees[transition.from];
+    }
+    fa.edges.resize(n);
+    std::vector<Automaton::EdgeTable::List*> lists(n, nullptr);
+    for (std::size_t index = 0; index < n; ++index) {
+      if (degrees[index] == 0) continue;
+      lists[index] = &fa.edges.write(index);
+      lists[index]->reserve(degrees[index]);
+    }
+    for (const auto& transition : transitions) {
+      lists[transition.from]->push_back({ transition.symbol, transition.to });
+    }
+    fa.sortEdges();
+
+    symbols.fill(false);
+    std::vector<int>().swap(states);
+    std::vector<int>().swap(initials);
+    std::vector<int>().swap(finals);
+    std::vector<Transition>().swap(transitions);
+    return fa;
+  }
+}
@@ -0,0 +1,106 @@
+#ifndef AUTOMATON_BUILDER_H
+#define AUTOMATON_BUILDER_H
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+#include "Automaton.h"
+
+namespace fa {
+
+  /**
+   * Transition between two states given by their ids
+   */
+  struct Transition {
+    int from;
+    char symbol;
+    int to;
+  };
+
+  /**
+   * Bulk construction of a large automaton.
+   *
+   * The builder only records what it is given, without any lookup: the
+   * states and the symbols used by the transitions are added implicitly, and
+   * the transitions are sorted and deduplicated all at once when the
+   * automaton is built, in O(E log E). The states of the automaton are
+   * indexed by increasing id.
+   */
+  class AutomatonBuilder {
+  public:
+    /**
+     * Build an empty builder. The automaton allocates from a memory resource.
+     */
+    explicit AutomatonBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * Reserve room for a number of states and of transitions
+     */
+    void reserve(std::size_t states, std::size_t transitions);
+
+    /**
+     * Add a symbol, even if no transition uses it.
+     *
+     * Throws std::invalid_argument if the symbol is not graphic.
+     */
+    void addSymbol(char symbol);
+
+    /**
+     * Add a state, even if no transition uses it.
+     *
+     * Throws std::invalid_argument if the state is negative.
+     */
+    void addState(int state);
+
+    /**
+     * Set the state initial, the state is added if needed.
+     */
+    void setStateInitial(int state);
+
+    /**
+     * Set the state final, the state is added if needed.
+     */
+    void setStateFinal(int state);
+
+    /**
+     * Add a transition labelled with a graphic symbol or fa::Epsilon.
+     *
+     * Throws std::invalid_argument if a state or the symbol is invalid.
+     */
+    void addTransition(int from, char alpha, int to);
+
+    /**
+     * Add the transitions of an array.
+     *
+     * Throws std::invalid_argument if one of them is invalid, none of them
+     * is added in this case.
+     */
+    void addTransitions(const Transition* transitions, std::size_t count);
+
+    /**
+     * Add the transitions of a contiguous range
+     */
+    template<typename Range>
+    void addTransitions(const Range& transitions) {
+      addTransitions(std::data(transitions), std::size(transitions));
+    }
+
+    /**
+     * Build the automaton, the builder is left empty.
+     */
+    Automaton build();
+
+  private:
+    std::pmr::memory_resource* resource;
+    std::array<bool, 256> symbols;
+    std::vector<int> states;
+    std::vector<int> initials;
+    std::vector<int> finals;
+    std::vector<Transition> transitions;
+  };
+}
+
+#endif // AUTOMATON_BUILDER_H
@@ -0,0 +1,112 @@
+#include "BatchMatcher.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace fa {
+
+  namespace {
+
+    // number of words taken at once by a thread
+    constexpr std::size_t Chunk = 64;
+
+  }
+
+  BatchMatcher::BatchMatcher(const CompiledAutomaton& automaton, unsigned threads)
+  : automaton(automaton)
+  , generation(0)
+  , running(0)
+  , stopping(false)
+  , batchWords(nullptr)
+  , batchCount(0)
+  , batchResults(nullptr)
+  , cursor(0)
+  {
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    scratches.resize(threads);
+    pool.reserve(threads - 1);
+    for (std::size_t worker = 1; worker < threads; ++worker) {
+      pool.emplace_back(&BatchMatcher::work, this, worker);
+    }
+  }
+
+  BatchMatcher::~BatchMatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  }
+
+  void BatchMatcher::drain(std::size_t worker) {
+    CompiledAutomaton::Scratch& scratch = scratches[worker];
+    for (;;) {
+      std::size_t first = cursor.fetch_add(Chunk);
+      if (first >= batchCount) return;
+      std::size_t last = std::min(first + Chunk, batchCount);
+      for (std::size_t i = first; i < last; ++i) {
+        batchResults[i] = automaton.match(batchWords[i], scratch);
+      }
+    }
+  }
+
+  void BatchMatcher::work(std::size_t worker) {
+    std::uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+      }
+
+      drain(worker);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) {
+          done.notify_one();
+        }
+      }
+    }
+  }
+
+  void BatchMatcher::matchAll(const std::string_view* words, std::size_t count, bool* results) {
+    std::lock_guard<std::mutex> batch(batchMutex);
+
+    batchWords = words;
+    batchCount = count;
+    batchResults = results;
+    cursor.store(0);
+
+    // small batches are not worth waking the pool
+    if (pool.empty() || count <= Chunk) {
+      drain(0);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = pool.size();
+      ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return running == 0; });
+  }
+
+  std::vector<bool> BatchMatcher::matchAll(const std::vector<std::string_view>& words) {
+    std::unique_ptr<bool[]> results(new bool[words.size()]);
+    matchAll(words.data(), words.size(), results.get());
+    return std::vector<bool>(results.get(), results.get() + words.size());
+  }
+}
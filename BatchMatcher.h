@@ -0,0 +1,82 @@
+#ifndef BATCH_MATCHER_H
+#define BATCH_MATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "CompiledAutomaton.h"
+
+namespace fa {
+
+  /**
+   * Match many words against a shared compiled automaton with a pool of
+   * threads.
+   *
+   * Every thread of the pool keeps its own scratch buffers, so matching does
+   * not allocate once the buffers are warm. The compiled automaton must
+   * outlive the matcher.
+   */
+  class BatchMatcher {
+  public:
+    /**
+     * Build a matcher with a number of threads, the calling thread included.
+     *
+     * With 0 threads, the number of hardware threads is used.
+     */
+    explicit BatchMatcher(const CompiledAutomaton& automaton, unsigned threads = 0);
+
+    BatchMatcher(const BatchMatcher&) = delete;
+    BatchMatcher& operator=(const BatchMatcher&) = delete;
+
+    ~BatchMatcher();
+
+    /**
+     * Compute the number of threads, the calling thread included.
+     */
+    std::size_t countThreads() const {
+      return scratches.size();
+    }
+
+    /**
+     * Tell for each word if it is in the language accepted by the automaton
+     *
+     * results[i] is set to the result of words[i], for i in [0, count).
+     */
+    void matchAll(const std::string_view* words, std::size_t count, bool* results);
+
+    /**
+     * Tell for each word if it is in the language accepted by the automaton
+     */
+    std::vector<bool> matchAll(const std::vector<std::string_view>& words);
+
+  private:
+    void work(std::size_t worker);
+    void drain(std::size_t worker);
+
+  private:
+    const CompiledAutomaton& automaton;
+    std::vector<CompiledAutomaton::Scratch> scratches;
+    std::vector<std::thread> pool;
+
+    std::mutex batchMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::uint64_t generation;
+    std::size_t running;
+    bool stopping;
+
+    const std::string_view* batchWords;
+    std::size_t batchCount;
+    bool* batchResults;
+    std::atomic<std::size_t> cursor;
+  };
+}
+
+#endif // BATCH_MATCHER_H
@@ -0,0 +1,148 @@
+#include "BitsetNfa.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace fa {
+
+  namespace {
+
+    constexpr std::size_t WordBits = 64;
+
+    int lowestBit(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_ctzll(word);
+#else
+      int bit = 0;
+      while ((word & 1) == 0) {
+        word >>= 1;
+        ++bit;
+      }
+      return bit;
+#endif
+    }
+
+    void orInto(std::uint64_t* dst, const std::uint64_t* src, std::size_t count) {
+      std::size_t i = 0;
+#if defined(__AVX2__)
+      for (; i + 4 <= count; i += 4) {
+        __m256i lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(lhs, rhs));
+      }
+#endif
+      for (; i < count; ++i) {
+        dst[i] |= src[i];
+      }
+    }
+
+    void setBit(std::uint64_t* set, int index) {
+      set[index / WordBits] |= std::uint64_t(1) << (index % WordBits);
+    }
+
+  }
+
+  BitsetNfa::BitsetNfa(const Automaton& automaton)
+  : compiled(automaton)
+  {
+    std::size_t n = compiled.countStates();
+    words = (n + WordBits - 1) / WordBits;
+
+    std::size_t nclasses = compiled.computeByteClasses(classes);
+    active.assign(nclasses * words, 0);
+    initial.assign(words, 0);
+    accepting.assign(words, 0);
+
+    for (int index : compiled.initialStates()) {
+      setBit(initial.data(), index);
+    }
+
+    std::size_t edges = n == 0 ? 0 : compiled.edgeEnd(static_cast<int>(n - 1));
+    maskFirst.resize(edges);
+    maskCount.resize(edges);
+    maskOffset.resize(edges);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      int index = static_cast<int>(i);
+      if (compiled.isFinal(index)) {
+        setBit(accepting.data(), index);
+      }
+
+      for (std::size_t edge = compiled.edgeBegin(index); edge < compiled.edgeEnd(index); ++edge) {
+        std::uint8_t cls = classes[static_cast<unsigned char>(compiled.edgeSymbol(edge))];
+        setBit(active.data() + cls * words, index);
+
+        // only the range of non-zero words of the target bitset is stored
+        const int* first = compiled.targetBegin(edge);
+        const int* last = compiled.targetEnd(edge);
+        std::size_t lo = *std::min_element(first, last) / WordBits;
+        std::size_t hi = *std::max_element(first, last) / WordBits + 1;
+
+        maskFirst[edge] = static_cast<std::uint32_t>(lo);
+        maskCount[edge] = static_cast<std::uint32_t>(hi - lo);
+        maskOffset[edge] = masks.size();
+        masks.resize(masks.size() + (hi - lo), 0);
+        for (const int* it = first; it != last; ++it) {
+          setBit(masks.data() + maskOffset[edge], *it - static_cast<int>(lo * WordBits));
+        }
+      }
+    }
+  }
+
+  void BitsetNfa::run(std::string_view word, std::vector<std::uint64_t>& current,
+      std::vector<std::uint64_t>& next) const {
+    current = initial;
+    next.assign(words, 0);
+
+    for (char c : word) {
+      const std::uint64_t* candidates = active.data() + classes[static_cast<unsigned char>(c)] * words;
+      bool alive = false;
+
+      for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t bits = current[w] & candidates[w];
+        while (bits != 0) {
+          int index = static_cast<int>(w * WordBits) + lowestBit(bits);
+          bits &= bits - 1;
+
+          std::size_t edge = compiled.findEdge(index, c);
+          orInto(next.data() + maskFirst[edge], masks.data() + maskOffset[edge], maskCount[edge]);
+          alive = true;
+        }
+      }
+
+      current.swap(next);
+      std::fill(next.begin(), next.end(), 0);
+      if (!alive) return;
+    }
+  }
+
+  std::set<int> BitsetNfa::readString(std::string_view word) const {
+    std::vector<std::uint64_t> current;
+    std::vector<std::uint64_t> next;
+    run(word, current, next);
+
+    std::set<int> path;
+    for (std::size_t w = 0; w < words; ++w) {
+      std::uint64_t bits = current[w];
+      while (bits != 0) {
+        path.insert(compiled.stateId(static_cast<int>(w * WordBits) + lowestBit(bits)));
+        bits &= bits - 1;
+      }
+    }
+    return path;
+  }
+
+  bool BitsetNfa::match(std::string_view word) const {
+    std::vector<std::uint64_t> current;
+    std::vector<std::uint64_t> next;
+    run(word, current, next);
+
+    for (std::size_t w = 0; w < words; ++w) {
+      if ((current[w] & accepting[w]) != 0) return true;
+    }
+    return false;
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef BITSET_NFA_H
+#define BITSET_NFA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "Automaton.h"
+#include "CompiledAutomaton.h"
+
+namespace fa {
+
+  /**
+   * Bit-parallel simulation of a non-deterministic automaton.
+   *
+   * The set of active states is a bitset over the dense state indices, and
+   * the targets of every (state, symbol) pair are precomputed as a bitset, so
+   * a step is an OR of the successor bitsets of the active states. It gives
+   * the same results as Automaton::readString() and Automaton::match().
+   */
+  class BitsetNfa {
+  public:
+    /**
+     * Build the bitsets of an automaton.
+     *
+     * Later modifications of the automaton are not reflected.
+     */
+    explicit BitsetNfa(const Automaton& automaton);
+
+    /**
+     * Compute the number of states.
+     */
+    std::size_t countStates() const {
+      return compiled.countStates();
+    }
+
+    /**
+     * Read the string and compute the state set after traversing the automaton
+     */
+    std::set<int> readString(std::string_view word) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word) const;
+
+  private:
+    void run(std::string_view word, std::vector<std::uint64_t>& current,
+        std::vector<std::uint64_t>& next) const;
+
+  private:
+    CompiledAutomaton compiled;
+    std::size_t words;
+    std::array<std::uint8_t, 256> classes;
+    // for each byte class, the states with a transition on it
+    std::vector<std::uint64_t> active;
+    std::vector<std::uint64_t> initial;
+    std::vector<std::uint64_t> accepting;
+    // for each edge of the compiled automaton, the non-zero words of its targets
+    std::vector<std::uint32_t> maskFirst;
+    std::vector<std::uint32_t> maskCount;
+    std::vector<std::size_t> maskOffset;
+    std::vector<std::uint64_t> masks;
+  };
+}
+
+#endif // BITSET_NFA_H
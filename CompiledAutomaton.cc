@@ -0,0 +1,171 @@
+#include "CompiledAutomaton.h"
+
+#include <algorithm>
+
+namespace fa {
+
+  CompiledAutomaton::CompiledAutomaton(const Automaton& automaton)
+  : ids(automaton.states->ids.begin(), automaton.states->ids.end())
+  {
+    // the automaton already numbers its states densely, the same indices are kept
+    finals.reserve(ids.size());
+    for (std::size_t index = 0; index < ids.size(); ++index) {
+      finals.push_back(automaton.isFinalAt(index) ? 1 : 0);
+    }
+
+    // epsilon-transitions are removed by jumping directly to the closure of
+    // the targets, the sets of active states are then always closed
+    initials = automaton.initialClosure();
+
+    edgeOffsets.reserve(ids.size() + 1);
+    edgeOffsets.push_back(0);
+    targetOffsets.push_back(0);
+    std::vector<int> closed;
+    for (const auto& list : automaton.edges) {
+      // the edges are sorted by symbol, each run becomes one compiled edge
+      for (auto it = list.begin(); it != list.end(); ) {
+        char alpha = it->symbol;
+        closed.clear();
+        for (; it != list.end() && it->symbol == alpha; ++it) {
+          automaton.addClosure(closed, it->to);
+        }
+        if (alpha == fa::Epsilon) continue;
+
+        std::sort(closed.begin(), closed.end());
+        closed.erase(std::unique(closed.begin(), closed.end()), closed.end());
+        symbols.push_back(alpha);
+        targets.insert(targets.end(), closed.begin(), closed.end());
+        targetOffsets.push_back(static_cast<std::uint32_t>(targets.size()));
+      }
+      edgeOffsets.push_back(static_cast<std::uint32_t>(symbols.size()));
+    }
+  }
+
+  std::size_t CompiledAutomaton::findEdge(int index, char alpha) const {
+    std::size_t first = edgeOffsets[index];
+    std::size_t last = edgeOffsets[index + 1];
+    auto it = std::lower_bound(symbols.begin() + first, symbols.begin() + last, alpha);
+    if (it == symbols.begin() + last || *it != alpha) return last;
+    return static_cast<std::size_t>(it - symbols.begin());
+  }
+
+  std::size_t CompiledAutomaton::computeByteClasses(std::array<std::uint8_t, 256>& classes) const {
+    // Refine the partition state by state: in each state, the bytes of a class
+    // are split according to the targets they lead to. Fresh class numbers
+    // are never reused, so the bytes without a transition keep their class.
+    std::array<int, 256> partition;
+    partition.fill(0);
+    int fresh = 1;
+
+    std::vector<std::size_t> edges;
+    std::vector<int> renamed;
+    for (std::size_t index = 0; index < ids.size(); ++index) {
+      std::size_t first = edgeOffsets[index];
+      std::size_t last = edgeOffsets[index + 1];
+      if (first == last) continue;
+
+      edges.clear();
+      for (std::size_t edge = first; edge < last; ++edge) {
+        edges.push_back(edge);
+      }
+
+      auto key = [&](std::size_t edge) {
+        return partition[static_cast<unsigned char>(symbols[edge])];
+      };
+      auto sameTargets = [&](std::size_t lhs, std::size_t rhs) {
+        return std::equal(targetBegin(lhs), targetEnd(lhs), targetBegin(rhs), targetEnd(rhs));
+      };
+      std::sort(edges.begin(), edges.end(), [&](std::size_t lhs, std::size_t rhs) {
+        if (key(lhs) != key(rhs)) return key(lhs) < key(rhs);
+        return std::lexicographical_compare(targetBegin(lhs), targetEnd(lhs),
+            targetBegin(rhs), targetEnd(rhs));
+      });
+
+      renamed.resize(edges.size());
+      for (std::size_t i = 0; i < edges.size(); ++i) {
+        if (i > 0 && key(edges[i]) == key(edges[i - 1]) && sameTargets(edges[i], edges[i - 1])) {
+          renamed[i] = renamed[i - 1];
+        } else {
+          renamed[i] = fresh++;
+        }
+      }
+      for (std::size_t i = 0; i < edges.size(); ++i) {
+        partition[static_cast<unsigned char>(symbols[edges[i]])] = renamed[i];
+      }
+    }
+
+    // renumber the classes densely, in order of first byte
+    std::vector<int> dense;
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+      auto it = std::find(dense.begin(), dense.end(), partition[byte]);
+      if (it == dense.end()) {
+        classes[byte] = static_cast<std::uint8_t>(dense.size());
+        dense.push_back(partition[byte]);
+      } else {
+        classes[byte] = static_cast<std::uint8_t>(it - dense.begin());
+      }
+    }
+    return dense.size();
+  }
+
+  void CompiledAutomaton::start(Scratch& scratch) const {
+    if (scratch.marks.size() < ids.size()) {
+      scratch.marks.resize(ids.size(), 0);
+    }
+    scratch.current.assign(initials.begin(), initials.end());
+  }
+
+  void CompiledAutomaton::advance(const char* first, const char* last, Scratch& scratch) const {
+    for (const char* c = first; c != last; ++c) {
+      if (scratch.current.empty()) return;
+
+      if (++scratch.stamp == 0) {
+        std::fill(scratch.marks.begin(), scratch.marks.end(), 0);
+        scratch.stamp = 1;
+      }
+
+      scratch.next.clear();
+      for (int from : scratch.current) {
+        std::size_t edge = findEdge(from, *c);
+        if (edge == edgeEnd(from)) continue;
+        for (const int* it = targetBegin(edge); it != targetEnd(edge); ++it) {
+          if (scratch.marks[*it] != scratch.stamp) {
+            scratch.marks[*it] = scratch.stamp;
+            scratch.next.push_back(*it);
+          }
+        }
+      }
+      scratch.current.swap(scratch.next);
+    }
+  }
+
+  bool CompiledAutomaton::accepts(const Scratch& scratch) const {
+    for (int index : scratch.current) {
+      if (finals[index]) return true;
+    }
+    return false;
+  }
+
+  std::set<int> CompiledAutomaton::readString(std::string_view word) const {
+    Scratch scratch;
+    start(scratch);
+    advance(word.data(), word.data() + word.size(), scratch);
+
+    std::set<int> path;
+    for (int index : scratch.current) {
+      path.insert(ids[index]);
+    }
+    return path;
+  }
+
+  bool CompiledAutomaton::match(std::string_view word) const {
+    Scratch scratch;
+    return match(word, scratch);
+  }
+
+  bool CompiledAutomaton::match(std::string_view word, Scratch& scratch) const {
+    start(scratch);
+    advance(word.data(), word.data() + word.size(), scratch);
+    return accepts(scratch);
+  }
+}
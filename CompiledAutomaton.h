@@ -0,0 +1,163 @@
+#ifndef COMPILED_AUTOMATON_H
+#define COMPILED_AUTOMATON_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "Automaton.h"
+
+namespace fa {
+
+  /**
+   * Read-only snapshot of an automaton, optimized for matching.
+   *
+   * States are renumbered with dense indices 0..n-1 and the transitions are
+   * stored in contiguous arrays: for each state a sorted list of symbols,
+   * and for each (state, symbol) pair the list of target indices.
+   */
+  class CompiledAutomaton {
+  public:
+    /**
+     * Buffers of a simulation, reused between matches to avoid allocations.
+     *
+     * A scratch must not be used by two threads at the same time.
+     */
+    class Scratch {
+    private:
+      friend class CompiledAutomaton;
+      friend class StreamMatcher;
+      std::vector<int> current;
+      std::vector<int> next;
+      std::vector<std::uint32_t> marks;
+      std::uint32_t stamp = 0;
+    };
+
+    /**
+     * Build a snapshot of the automaton.
+     *
+     * Later modifications of the automaton are not reflected in the snapshot.
+     */
+    explicit CompiledAutomaton(const Automaton& automaton);
+
+    /**
+     * Compute the number of states.
+     */
+    std::size_t countStates() const {
+      return ids.size();
+    }
+
+    /**
+     * Compute the number of transitions.
+     */
+    std::size_t countTransitions() const {
+      return targets.size();
+    }
+
+    /**
+     * Get the state number of a dense index.
+     */
+    int stateId(int index) const {
+      return ids[index];
+    }
+
+    /**
+     * Tell if the state at a dense index is final.
+     */
+    bool isFinal(int index) const {
+      return finals[index] != 0;
+    }
+
+    /**
+     * Get the dense indices of the initial states.
+     */
+    const std::vector<int>& initialStates() const {
+      return initials;
+    }
+
+    /**
+     * Get the range of edges leaving a state, as edge indices.
+     *
+     * An edge groups all the targets of one (state, symbol) pair. The edges of
+     * a state are sorted by symbol.
+     */
+    std::size_t edgeBegin(int index) const {
+      return edgeOffsets[index];
+    }
+
+    std::size_t edgeEnd(int index) const {
+      return edgeOffsets[index + 1];
+    }
+
+    /**
+     * Get the symbol of an edge.
+     */
+    char edgeSymbol(std::size_t edge) const {
+      return symbols[edge];
+    }
+
+    /**
+     * Get the targets of an edge, as dense indices.
+     */
+    const int* targetBegin(std::size_t edge) const {
+      return targets.data() + targetOffsets[edge];
+    }
+
+    const int* targetEnd(std::size_t edge) const {
+      return targets.data() + targetOffsets[edge + 1];
+    }
+
+    /**
+     * Find the edge of a state labelled with a symbol.
+     *
+     * Returns edgeEnd(index) if there is no such edge.
+     */
+    std::size_t findEdge(int index, char alpha) const;
+
+    /**
+     * Partition the 256 byte values into classes of bytes that behave
+     * identically in every state.
+     *
+     * Bytes without any transition share the class of byte 0.
+     * Returns the number of classes.
+     */
+    std::size_t computeByteClasses(std::array<std::uint8_t, 256>& classes) const;
+
+    /**
+     * Read the string and compute the state set after traversing the automaton
+     */
+    std::set<int> readString(std::string_view word) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton, using
+     * the buffers of a scratch
+     */
+    bool match(std::string_view word, Scratch& scratch) const;
+
+  private:
+    friend class StreamMatcher;
+
+    void start(Scratch& scratch) const;
+    void advance(const char* first, const char* last, Scratch& scratch) const;
+    bool accepts(const Scratch& scratch) const;
+
+  private:
+    std::vector<int> ids;
+    std::vector<unsigned char> finals;
+    std::vector<int> initials;
+    std::vector<std::uint32_t> edgeOffsets;
+    std::vector<char> symbols;
+    std::vector<std::uint32_t> targetOffsets;
+    std::vector<int> targets;
+  };
+}
+
+#endif // COMPILED_AUTOMATON_H
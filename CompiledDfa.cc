@@ -0,0 +1,65 @@
+#include "CompiledDfa.h"
+
+#include <limits>
+#include <stdexcept>
+
+#include "CompiledAutomaton.h"
+
+namespace fa {
+
+  namespace {
+
+    CompiledAutomaton compileDeterministic(const Automaton& automaton) {
+      if (automaton.isDeterministic()) return CompiledAutomaton(automaton);
+      return CompiledAutomaton(Automaton::createDeterministic(automaton));
+    }
+
+  }
+
+  CompiledDfa::CompiledDfa(const Automaton& automaton) {
+    CompiledAutomaton dfa = compileDeterministic(automaton);
+
+    stride = static_cast<std::uint32_t>(dfa.computeByteClasses(classes));
+
+    std::size_t rows = dfa.countStates() + 1;
+    if (rows > std::numeric_limits<std::uint32_t>::max() / stride) {
+      throw std::length_error("CompiledDfa: transition table too large");
+    }
+
+    std::array<unsigned char, 256> representative;
+    for (std::size_t byte = 256; byte-- > 0;) {
+      representative[classes[byte]] = static_cast<unsigned char>(byte);
+    }
+
+    table.assign(rows * stride, 0);
+    accepting.assign(rows, 0);
+    ids.assign(rows, -1);
+
+    for (std::size_t index = 0; index < dfa.countStates(); ++index) {
+      int state = static_cast<int>(index);
+      std::size_t row = (index + 1) * stride;
+      for (std::size_t cls = 0; cls < stride; ++cls) {
+        std::size_t edge = dfa.findEdge(state, static_cast<char>(representative[cls]));
+        if (edge == dfa.edgeEnd(state)) continue;
+        int target = *dfa.targetBegin(edge);
+        table[row + cls] = static_cast<std::uint32_t>((target + 1) * stride);
+      }
+      accepting[index + 1] = dfa.isFinal(state) ? 1 : 0;
+      ids[index + 1] = dfa.stateId(state);
+    }
+
+    start = 0;
+    if (!dfa.initialStates().empty()) {
+      start = static_cast<std::uint32_t>((dfa.initialStates().front() + 1) * stride);
+    }
+  }
+
+  std::set<int> CompiledDfa::readString(std::string_view word) const {
+    std::set<int> path;
+    std::uint32_t state = run(word);
+    if (state != 0) {
+      path.insert(ids[state / stride]);
+    }
+    return path;
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef COMPILED_DFA_H
+#define COMPILED_DFA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "Automaton.h"
+
+namespace fa {
+
+  /**
+   * Deterministic automaton compiled to a dense transition table.
+   *
+   * The 256 byte values are grouped in classes of bytes that behave
+   * identically, and each state is a row of the table indexed by the class.
+   * Missing transitions lead to a dead row, so matching never branches.
+   */
+  class CompiledDfa {
+  public:
+    /**
+     * Build the table of an automaton.
+     *
+     * The automaton is determinized first if it is not deterministic.
+     */
+    explicit CompiledDfa(const Automaton& automaton);
+
+    /**
+     * Compute the number of states, the dead state excluded.
+     */
+    std::size_t countStates() const {
+      return ids.size() - 1;
+    }
+
+    /**
+     * Compute the number of byte classes.
+     */
+    std::size_t countClasses() const {
+      return stride;
+    }
+
+    /**
+     * Read the string and compute the state set after traversing the automaton
+     */
+    std::set<int> readString(std::string_view word) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word) const {
+      return accepting[run(word) / stride] != 0;
+    }
+
+  private:
+    std::uint32_t run(std::string_view word) const {
+      std::uint32_t state = start;
+      for (char c : word) {
+        state = table[state + classes[static_cast<unsigned char>(c)]];
+      }
+      return state;
+    }
+
+  private:
+    std::array<std::uint8_t, 256> classes;
+    std::uint32_t stride;
+    std::uint32_t start;
+    // row offsets are premultiplied by the stride, row 0 is the dead state
+    std::vector<std::uint32_t> table;
+    std::vector<unsigned char> accepting;
+    std::vector<int> ids;
+  };
+}
+
+#endif // COMPILED_DFA_H
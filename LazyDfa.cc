@@ -0,0 +1,177 @@
+#include "LazyDfa.h"
+
+#include <algorithm>
+
+namespace fa {
+
+  namespace {
+
+    std::size_t hashSet(const int* first, const int* last) {
+      std::uint64_t hash = 14695981039346656037ull;
+      for (const int* it = first; it != last; ++it) {
+        hash = (hash ^ static_cast<std::uint32_t>(*it)) * 1099511628211ull;
+      }
+      return static_cast<std::size_t>(hash);
+    }
+
+  }
+
+  LazyDfa::LazyDfa(const Automaton& automaton, std::size_t memoryBudget)
+  : compiled(automaton)
+  , budget(memoryBudget)
+  , flushes(0)
+  , stamp(0)
+  {
+    stride = compiled.computeByteClasses(classes);
+    for (std::size_t byte = 256; byte-- > 0;) {
+      representative[classes[byte]] = static_cast<unsigned char>(byte);
+    }
+
+    startSet = compiled.initialStates();
+    std::sort(startSet.begin(), startSet.end());
+    marks.assign(compiled.countStates(), 0);
+
+    flush();
+    flushes = 0;
+  }
+
+  std::size_t LazyDfa::memoryUsage() const {
+    return table.size() * sizeof(int)
+      + accepting.size() * sizeof(unsigned char)
+      + hashes.size() * sizeof(std::size_t)
+      + setOffsets.size() * sizeof(std::uint32_t)
+      + setPool.size() * sizeof(int)
+      + buckets.size() * sizeof(int);
+  }
+
+  std::size_t LazyDfa::stateCost(std::size_t setSize) const {
+    std::size_t cost = stride * sizeof(int) + sizeof(unsigned char) + sizeof(std::size_t)
+      + sizeof(std::uint32_t) + setSize * sizeof(int);
+    // the buckets are doubled when they become half full
+    if (2 * (hashes.size() + 1) > buckets.size()) {
+      cost += buckets.size() * sizeof(int);
+    }
+    return cost;
+  }
+
+  void LazyDfa::flush() {
+    table.clear();
+    accepting.clear();
+    hashes.clear();
+    setOffsets.assign(1, 0);
+    setPool.clear();
+    buckets.assign(64, Unknown);
+    ++flushes;
+
+    intern({});
+    start = intern(startSet);
+  }
+
+  int LazyDfa::find(const std::vector<int>& set, std::size_t hash) const {
+    std::size_t mask = buckets.size() - 1;
+    for (std::size_t slot = hash & mask; buckets[slot] != Unknown; slot = (slot + 1) & mask) {
+      int state = buckets[slot];
+      if (hashes[state] != hash) continue;
+      const int* first = setPool.data() + setOffsets[state];
+      const int* last = setPool.data() + setOffsets[state + 1];
+      if (std::equal(first, last, set.begin(), set.end())) return state;
+    }
+    return Unknown;
+  }
+
+  int LazyDfa::intern(const std::vector<int>& set) {
+    std::size_t hash = hashSet(set.data(), set.data() + set.size());
+    int state = find(set, hash);
+    if (state != Unknown) return state;
+
+    state = static_cast<int>(hashes.size());
+    hashes.push_back(hash);
+    setPool.insert(setPool.end(), set.begin(), set.end());
+    setOffsets.push_back(static_cast<std::uint32_t>(setPool.size()));
+
+    bool final = std::any_of(set.begin(), set.end(), [this](int s) { return compiled.isFinal(s); });
+    accepting.push_back(final ? 1 : 0);
+    table.resize(table.size() + stride, set.empty() ? Dead : Unknown);
+
+    if (2 * hashes.size() > buckets.size()) {
+      std::vector<int> old(2 * buckets.size(), Unknown);
+      buckets.swap(old);
+      std::size_t mask = buckets.size() - 1;
+      for (int s : old) {
+        if (s == Unknown) continue;
+        std::size_t slot = hashes[s] & mask;
+        while (buckets[slot] != Unknown) slot = (slot + 1) & mask;
+        buckets[slot] = s;
+      }
+    } else {
+      std::size_t mask = buckets.size() - 1;
+      std::size_t slot = hash & mask;
+      while (buckets[slot] != Unknown) slot = (slot + 1) & mask;
+      buckets[slot] = state;
+    }
+    return state;
+  }
+
+  int LazyDfa::computeNext(int state, std::uint8_t cls) {
+    if (++stamp == 0) {
+      std::fill(marks.begin(), marks.end(), 0);
+      stamp = 1;
+    }
+
+    char alpha = static_cast<char>(representative[cls]);
+    successor.clear();
+    for (std::uint32_t i = setOffsets[state]; i < setOffsets[state + 1]; ++i) {
+      int from = setPool[i];
+      std::size_t edge = compiled.findEdge(from, alpha);
+      if (edge == compiled.edgeEnd(from)) continue;
+      for (const int* it = compiled.targetBegin(edge); it != compiled.targetEnd(edge); ++it) {
+        if (marks[*it] != stamp) {
+          marks[*it] = stamp;
+          successor.push_back(*it);
+        }
+      }
+    }
+    std::sort(successor.begin(), successor.end());
+
+    int next = find(successor, hashSet(successor.data(), successor.data() + successor.size()));
+    if (next == Unknown) {
+      if (hashes.size() > 2 && memoryUsage() + stateCost(successor.size()) > budget) {
+        std::vector<int> current(setPool.begin() + setOffsets[state], setPool.begin() + setOffsets[state + 1]);
+        flush();
+        state = intern(current);
+      }
+      next = intern(successor);
+    }
+
+    table[state * stride + cls] = next;
+    return next;
+  }
+
+  int LazyDfa::run(std::string_view word) {
+    int state = start;
+    for (char c : word) {
+      std::uint8_t cls = classes[static_cast<unsigned char>(c)];
+      int next = table[state * stride + cls];
+      if (next == Unknown) {
+        next = computeNext(state, cls);
+      }
+      state = next;
+      if (state == Dead) break;
+    }
+    return state;
+  }
+
+  std::set<int> LazyDfa::readString(std::string_view word) {
+    int state = run(word);
+
+    std::set<int> path;
+    for (std::uint32_t i = setOffsets[state]; i < setOffsets[state + 1]; ++i) {
+      path.insert(compiled.stateId(setPool[i]));
+    }
+    return path;
+  }
+
+  bool LazyDfa::match(std::string_view word) {
+    return accepting[run(word)] != 0;
+  }
+}
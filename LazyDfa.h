@@ -0,0 +1,102 @@
+#ifndef LAZY_DFA_H
+#define LAZY_DFA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "Automaton.h"
+#include "CompiledAutomaton.h"
+
+namespace fa {
+
+  /**
+   * Matcher that determinizes an automaton on the fly.
+   *
+   * Only the sets of states that are actually reached by the inputs become
+   * deterministic states. They are kept in a cache whose size is bounded by a
+   * memory budget: when the cache is full, it is flushed and rebuilt from the
+   * current position. Matching modifies the cache, so a LazyDfa must not be
+   * shared between threads.
+   */
+  class LazyDfa {
+  public:
+    static constexpr std::size_t DefaultMemoryBudget = std::size_t(8) << 20;
+
+    /**
+     * Build a matcher for an automaton, with a cache of at most memoryBudget
+     * bytes.
+     *
+     * Later modifications of the automaton are not reflected.
+     */
+    explicit LazyDfa(const Automaton& automaton, std::size_t memoryBudget = DefaultMemoryBudget);
+
+    /**
+     * Compute the number of deterministic states in the cache.
+     */
+    std::size_t countCachedStates() const {
+      return hashes.size();
+    }
+
+    /**
+     * Compute the number of times the cache was flushed.
+     */
+    std::size_t countFlushes() const {
+      return flushes;
+    }
+
+    /**
+     * Compute the memory used by the cache, in bytes.
+     */
+    std::size_t memoryUsage() const;
+
+    /**
+     * Read the string and compute the state set after traversing the automaton
+     */
+    std::set<int> readString(std::string_view word);
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word);
+
+  private:
+    int run(std::string_view word);
+    int computeNext(int state, std::uint8_t cls);
+    int find(const std::vector<int>& set, std::size_t hash) const;
+    int intern(const std::vector<int>& set);
+    void flush();
+    std::size_t stateCost(std::size_t setSize) const;
+
+  private:
+    static constexpr int Dead = 0;
+    static constexpr int Unknown = -1;
+
+    CompiledAutomaton compiled;
+    std::array<std::uint8_t, 256> classes;
+    std::array<unsigned char, 256> representative;
+    std::size_t stride;
+    std::size_t budget;
+    std::size_t flushes;
+    int start;
+
+    // cached deterministic states
+    std::vector<int> table;
+    std::vector<unsigned char> accepting;
+    std::vector<std::size_t> hashes;
+    std::vector<std::uint32_t> setOffsets;
+    std::vector<int> setPool;
+    std::vector<int> buckets;
+
+    // scratch buffers for the successor computation
+    std::vector<int> startSet;
+    std::vector<int> successor;
+    std::vector<std::uint32_t> marks;
+    std::uint32_t stamp;
+  };
+}
+
+#endif // LAZY_DFA_H
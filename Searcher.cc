@@ -0,0 +1,193 @@
+#include "Searcher.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fa {
+
+  namespace {
+
+    // longest literal prefix extracted from the automaton
+    constexpr std::size_t MaxPrefix = 64;
+
+  }
+
+  Searcher::Searcher(const CompiledAutomaton& automaton)
+  : automaton(automaton)
+  , acceptsEmpty(false)
+  , countFirstBytes(0)
+  , firstByte(0)
+  {
+    const std::vector<int>& initials = automaton.initialStates();
+    firstBytes.fill(false);
+    for (int index : initials) {
+      if (automaton.isFinal(index)) {
+        acceptsEmpty = true;
+      }
+      for (std::size_t edge = automaton.edgeBegin(index); edge < automaton.edgeEnd(index); ++edge) {
+        unsigned char byte = static_cast<unsigned char>(automaton.edgeSymbol(edge));
+        if (!firstBytes[byte]) {
+          firstBytes[byte] = true;
+          firstByte = static_cast<char>(byte);
+          ++countFirstBytes;
+        }
+      }
+    }
+
+    // Follow the states while they all agree on a single symbol and none of
+    // them is final: every accepted word starts with these symbols.
+    std::vector<int> set(initials.begin(), initials.end());
+    std::vector<int> next;
+    while (prefix.size() < MaxPrefix) {
+      bool final = false;
+      bool single = true;
+      std::size_t edges = 0;
+      char symbol = 0;
+      for (int index : set) {
+        final = final || automaton.isFinal(index);
+        for (std::size_t edge = automaton.edgeBegin(index); edge < automaton.edgeEnd(index); ++edge) {
+          if (edges++ == 0) {
+            symbol = automaton.edgeSymbol(edge);
+          } else if (automaton.edgeSymbol(edge) != symbol) {
+            single = false;
+          }
+        }
+      }
+      if (final || edges == 0 || !single) break;
+
+      prefix.push_back(symbol);
+      next.clear();
+      for (int index : set) {
+        std::size_t edge = automaton.findEdge(index, symbol);
+        if (edge == automaton.edgeEnd(index)) continue;
+        next.insert(next.end(), automaton.targetBegin(edge), automaton.targetEnd(edge));
+      }
+      std::sort(next.begin(), next.end());
+      next.erase(std::unique(next.begin(), next.end()), next.end());
+      set.swap(next);
+    }
+  }
+
+  std::size_t Searcher::nextCandidate(std::string_view text, std::size_t pos) const {
+    if (pos >= text.size()) return std::string_view::npos;
+
+    if (!prefix.empty()) {
+      return text.find(prefix, pos);
+    }
+
+    if (countFirstBytes == 0) return std::string_view::npos;
+
+    if (countFirstBytes == 1) {
+      const void* found = std::memchr(text.data() + pos, firstByte, text.size() - pos);
+      if (found == nullptr) return std::string_view::npos;
+      return static_cast<std::size_t>(static_cast<const char*>(found) - text.data());
+    }
+
+    for (; pos < text.size(); ++pos) {
+      if (firstBytes[static_cast<unsigned char>(text[pos])]) return pos;
+    }
+    return std::string_view::npos;
+  }
+
+  bool Searcher::isCandidate(std::string_view text, std::size_t pos) const {
+    if (pos >= text.size()) return false;
+    if (!prefix.empty()) {
+      return text.compare(pos, prefix.size(), prefix) == 0;
+    }
+    return firstBytes[static_cast<unsigned char>(text[pos])];
+  }
+
+  std::optional<Match> Searcher::search(std::string_view text, std::size_t from, Scratch& scratch) const {
+    if (from > text.size()) return std::nullopt;
+    if (acceptsEmpty) return Match{ from, from };
+
+    std::size_t n = automaton.countStates();
+    if (scratch.marks.size() < n) {
+      scratch.marks.resize(n, 0);
+      scratch.starts.resize(n, 0);
+      scratch.nextStarts.resize(n, 0);
+    }
+
+    auto bump = [&scratch]() {
+      if (++scratch.stamp == 0) {
+        std::fill(scratch.marks.begin(), scratch.marks.end(), 0);
+        scratch.stamp = 1;
+      }
+    };
+
+    // every active state remembers the leftmost start of the matches it is
+    // part of, the starts of the next states are kept apart until the step ends
+    std::vector<int>& current = scratch.current;
+    std::vector<int>& next = scratch.next;
+    std::vector<std::size_t>& starts = scratch.starts;
+    std::vector<std::size_t>& nextStarts = scratch.nextStarts;
+    current.clear();
+    bump();
+
+    std::size_t pos = from;
+    for (;;) {
+      if (current.empty()) {
+        pos = nextCandidate(text, pos);
+        if (pos == std::string_view::npos) return std::nullopt;
+      }
+
+      if (isCandidate(text, pos)) {
+        for (int index : automaton.initialStates()) {
+          if (scratch.marks[index] != scratch.stamp) {
+            scratch.marks[index] = scratch.stamp;
+            starts[index] = pos;
+            current.push_back(index);
+          }
+        }
+      }
+
+      if (pos == text.size()) return std::nullopt;
+
+      char c = text[pos++];
+      bump();
+      next.clear();
+      for (int state : current) {
+        std::size_t edge = automaton.findEdge(state, c);
+        if (edge == automaton.edgeEnd(state)) continue;
+        for (const int* it = automaton.targetBegin(edge); it != automaton.targetEnd(edge); ++it) {
+          if (scratch.marks[*it] != scratch.stamp) {
+            scratch.marks[*it] = scratch.stamp;
+            nextStarts[*it] = starts[state];
+            next.push_back(*it);
+          } else {
+            nextStarts[*it] = std::min(nextStarts[*it], starts[state]);
+          }
+        }
+      }
+
+      std::size_t best = std::string_view::npos;
+      for (int index : next) {
+        if (automaton.isFinal(index)) {
+          best = std::min(best, nextStarts[index]);
+        }
+      }
+      if (best != std::string_view::npos) return Match{ best, pos };
+
+      current.swap(next);
+      starts.swap(nextStarts);
+    }
+  }
+
+  std::optional<Match> Searcher::find(std::string_view text, std::size_t from) const {
+    Scratch scratch;
+    return search(text, from, scratch);
+  }
+
+  std::vector<Match> Searcher::findAll(std::string_view text) const {
+    Scratch scratch;
+    std::vector<Match> matches;
+    std::size_t from = 0;
+    for (;;) {
+      std::optional<Match> match = search(text, from, scratch);
+      if (!match) break;
+      matches.push_back(*match);
+      from = match->end > match->start ? match->end : match->end + 1;
+    }
+    return matches;
+  }
+}
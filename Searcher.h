@@ -0,0 +1,84 @@
+#ifndef SEARCHER_H
+#define SEARCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CompiledAutomaton.h"
+
+namespace fa {
+
+  /**
+   * Position of a factor of a text accepted by an automaton: text[start, end)
+   */
+  struct Match {
+    std::size_t start;
+    std::size_t end;
+  };
+
+  /**
+   * Unanchored search of the words of a language inside a text.
+   *
+   * At construction, the searcher extracts the literal prefix shared by all
+   * the non-empty accepted words (or at least the set of their first bytes),
+   * and uses it to skip the parts of the text where no match can start,
+   * without running the automaton. The compiled automaton must outlive the
+   * searcher.
+   */
+  class Searcher {
+  public:
+    explicit Searcher(const CompiledAutomaton& automaton);
+
+    /**
+     * Get the literal that starts every non-empty accepted word.
+     */
+    const std::string& requiredPrefix() const {
+      return prefix;
+    }
+
+    /**
+     * Find the first match in the text, from an offset.
+     *
+     * The first match is the one that ends first; among the matches ending
+     * at the same offset, it is the one that starts first.
+     */
+    std::optional<Match> find(std::string_view text, std::size_t from = 0) const;
+
+    /**
+     * Find all the successive non-overlapping matches in the text.
+     *
+     * After a match, the search resumes at its end (one byte later for an
+     * empty match).
+     */
+    std::vector<Match> findAll(std::string_view text) const;
+
+  private:
+    struct Scratch {
+      std::vector<int> current;
+      std::vector<int> next;
+      std::vector<std::size_t> starts;
+      std::vector<std::size_t> nextStarts;
+      std::vector<std::uint32_t> marks;
+      std::uint32_t stamp = 0;
+    };
+
+    std::optional<Match> search(std::string_view text, std::size_t from, Scratch& scratch) const;
+    std::size_t nextCandidate(std::string_view text, std::size_t pos) const;
+    bool isCandidate(std::string_view text, std::size_t pos) const;
+
+  private:
+    const CompiledAutomaton& automaton;
+    bool acceptsEmpty;
+    std::string prefix;
+    std::array<bool, 256> firstBytes;
+    std::size_t countFirstBytes;
+    char firstByte;
+  };
+}
+
+#endif // SEARCHER_H
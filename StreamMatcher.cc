@@ -0,0 +1,40 @@
+#include "StreamMatcher.h"
+
+namespace fa {
+
+  StreamMatcher::StreamMatcher(const CompiledAutomaton& automaton)
+  : automaton(automaton)
+  , offset(0)
+  {
+    // a state set never holds more than all the states
+    scratch.current.reserve(automaton.countStates());
+    scratch.next.reserve(automaton.countStates());
+    reset();
+  }
+
+  void StreamMatcher::reset() {
+    automaton.start(scratch);
+    offset = 0;
+  }
+
+  void StreamMatcher::feed(const char* data, std::size_t size) {
+    automaton.advance(data, data + size, scratch);
+    offset += size;
+  }
+
+  bool StreamMatcher::accepting() const {
+    return automaton.accepts(scratch);
+  }
+
+  bool StreamMatcher::dead() const {
+    return scratch.current.empty();
+  }
+
+  std::set<int> StreamMatcher::currentStates() const {
+    std::set<int> states;
+    for (int index : scratch.current) {
+      states.insert(automaton.stateId(index));
+    }
+    return states;
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef STREAM_MATCHER_H
+#define STREAM_MATCHER_H
+
+#include <cstddef>
+#include <set>
+#include <string_view>
+
+#include "CompiledAutomaton.h"
+
+namespace fa {
+
+  /**
+   * Incremental matcher: the word is given chunk by chunk.
+   *
+   * The buffers are allocated once at construction, feeding a chunk never
+   * allocates. The compiled automaton must outlive the matcher.
+   */
+  class StreamMatcher {
+  public:
+    /**
+     * Build a matcher positioned at the beginning of a word.
+     */
+    explicit StreamMatcher(const CompiledAutomaton& automaton);
+
+    /**
+     * Go back to the beginning of a word.
+     */
+    void reset();
+
+    /**
+     * Read the next chunk of the word.
+     */
+    void feed(const char* data, std::size_t size);
+
+    void feed(std::string_view chunk) {
+      feed(chunk.data(), chunk.size());
+    }
+
+    /**
+     * Tell if the word read so far is in the language accepted by the automaton
+     */
+    bool accepting() const;
+
+    /**
+     * Tell if no continuation of the word read so far can be accepted
+     * because no state is active anymore.
+     */
+    bool dead() const;
+
+    /**
+     * Compute the number of bytes read since the beginning of the word.
+     */
+    std::size_t position() const {
+      return offset;
+    }
+
+    /**
+     * Compute the current state set
+     */
+    std::set<int> currentStates() const;
+
+  private:
+    const CompiledAutomaton& automaton;
+    CompiledAutomaton::Scratch scratch;
+    std::size_t offset;
+  };
+}
+
+#endif // STREAM_MATCHER_H
@@ -1,6 +1,6 @@
 #!/bin/sh
 
-FILES="Automaton.cc Automaton.h testfa.cc"
+FILES="Automaton.cc Automaton.h AutomatonBuilder.cc AutomatonBuilder.h BatchMatcher.cc BatchMatcher.h BitsetNfa.cc BitsetNfa.h CompiledAutomaton.cc CompiledAutomaton.h CompiledDfa.cc CompiledDfa.h LazyDfa.cc LazyDfa.h Searcher.cc Searcher.h StreamMatcher.cc StreamMatcher.h testfa.cc"
 BASE_DIR="$(mktemp -d)"
 FILE_DIR="automate"
 ARCHIVE=automate.tar.gz
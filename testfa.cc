@@ -1,8 +1,20 @@
 #include "gtest/gtest.h"
 
 #include "Automaton.h"
-
+#include "AutomatonBuilder.h"
+#include "BatchMatcher.h"
+#include "BitsetNfa.h"
+#include "CompiledAutomaton.h"
+#include "CompiledDfa.h"
+#include "LazyDfa.h"
+#include "Searcher.h"
+#include "StreamMatcher.h"
+
+#include <atomic>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <type_traits>
 
 // --- TEST AutomatonIsValid ---
 
@@ -1212,6 +1224,2139 @@ TEST(AutomatonMatch, ManyInitialState) {
     EXPECT_TRUE(fa.match("a"));
 }
 
+// --- COMPILEDAUTOMATON ---
+TEST(CompiledAutomaton, Counts) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(3));
+    EXPECT_TRUE(fa.addState(7));
+
+    fa.setStateInitial(3);
+    fa.setStateFinal(7);
+
+    EXPECT_TRUE(fa.addTransition(3, 'a', 7));
+    EXPECT_TRUE(fa.addTransition(3, 'a', 3));
+    EXPECT_TRUE(fa.addTransition(7, 'b', 3));
+
+    fa::CompiledAutomaton compiled(fa);
+    EXPECT_EQ(2u, compiled.countStates());
+    EXPECT_EQ(3u, compiled.countTransitions());
+}
+
+TEST(CompiledAutomaton, ReadString) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(3));
+    EXPECT_TRUE(fa.addState(7));
+    EXPECT_TRUE(fa.addState(9));
+
+    fa.setStateInitial(3);
+    fa.setStateFinal(9);
+
+    EXPECT_TRUE(fa.addTransition(3, 'a', 3));
+    EXPECT_TRUE(fa.addTransition(3, 'a', 7));
+    EXPECT_TRUE(fa.addTransition(7, 'b', 9));
+
+    fa::CompiledAutomaton compiled(fa);
+    for (std::string word : {"", "a", "aa", "ab", "aab", "b", "abb", "ac"}) {
+        EXPECT_EQ(fa.readString(word), compiled.readString(word));
+    }
+}
+
+TEST(CompiledAutomaton, Match) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateInitial(1);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 2));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+    EXPECT_TRUE(fa.addTransition(2, 'a', 2));
+
+    fa::CompiledAutomaton compiled(fa);
+    EXPECT_TRUE(compiled.match("a"));
+    EXPECT_TRUE(compiled.match("b"));
+    EXPECT_TRUE(compiled.match("baaa"));
+    EXPECT_FALSE(compiled.match(""));
+    EXPECT_FALSE(compiled.match("ab"));
+    EXPECT_FALSE(compiled.match(std::string(1, fa::Epsilon)));
+}
+
+TEST(CompiledAutomaton, Snapshot) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+
+    fa::CompiledAutomaton compiled(fa);
+    EXPECT_TRUE(fa.removeTransition(0, 'a', 1));
+
+    EXPECT_FALSE(fa.match("a"));
+    EXPECT_TRUE(compiled.match("a"));
+}
+
+// --- COMPILEDDFA ---
+TEST(CompiledDfa, ByteClasses) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+    EXPECT_TRUE(fa.addSymbol('c'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'c', 0));
+
+    fa::CompiledDfa dfa(fa);
+    EXPECT_EQ(2u, dfa.countStates());
+    EXPECT_EQ(3u, dfa.countClasses());
+}
+
+TEST(CompiledDfa, Match) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+    EXPECT_TRUE(fa.addTransition(2, 'a', 1));
+
+    fa::CompiledDfa dfa(fa);
+    for (std::string word : {"", "a", "ab", "aba", "abab", "abb", "b", "abc"}) {
+        EXPECT_EQ(fa.match(word), dfa.match(word));
+        EXPECT_EQ(fa.readString(word), dfa.readString(word));
+    }
+}
+
+TEST(CompiledDfa, NonDeterministic) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+
+    fa::CompiledDfa dfa(fa);
+    for (std::string word : {"", "ab", "aab", "bab", "aba", "abbab", "b"}) {
+        EXPECT_EQ(fa.match(word), dfa.match(word));
+    }
+}
+
+// --- BITSETNFA ---
+TEST(BitsetNfa, ReadString) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+
+    fa::BitsetNfa nfa(fa);
+    for (std::string word : {"", "a", "ab", "aab", "bab", "aba", "abbab", "b", "ac"}) {
+        EXPECT_EQ(fa.readString(word), nfa.readString(word));
+        EXPECT_EQ(fa.match(word), nfa.match(word));
+    }
+}
+
+TEST(BitsetNfa, ManyStates) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    // the 150th letter from the end is an 'a'
+    for (int i = 0; i <= 150; ++i) {
+        EXPECT_TRUE(fa.addState(i));
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(150);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    for (int i = 1; i < 150; ++i) {
+        EXPECT_TRUE(fa.addTransition(i, 'a', i + 1));
+        EXPECT_TRUE(fa.addTransition(i, 'b', i + 1));
+    }
+
+    fa::BitsetNfa nfa(fa);
+    EXPECT_EQ(151u, nfa.countStates());
+
+    std::string word = "b" + std::string(149, 'b');
+    EXPECT_FALSE(nfa.match(word));
+    EXPECT_EQ(fa.readString(word), nfa.readString(word));
+
+    word = "ba" + std::string(149, 'b');
+    EXPECT_TRUE(nfa.match(word));
+    EXPECT_EQ(fa.readString(word), nfa.readString(word));
+}
+
+// --- LAZYDFA ---
+TEST(LazyDfa, Match) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+
+    fa::LazyDfa dfa(fa);
+    for (std::string word : {"", "a", "ab", "aab", "bab", "aba", "abbab", "b", "ac"}) {
+        EXPECT_EQ(fa.readString(word), dfa.readString(word));
+        EXPECT_EQ(fa.match(word), dfa.match(word));
+    }
+    EXPECT_EQ(0u, dfa.countFlushes());
+}
+
+TEST(LazyDfa, OnlyReachedStates) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    // the 10th letter from the end is an 'a': 1024 states once determinized
+    for (int i = 0; i <= 10; ++i) {
+        EXPECT_TRUE(fa.addState(i));
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(10);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    for (int i = 1; i < 10; ++i) {
+        EXPECT_TRUE(fa.addTransition(i, 'a', i + 1));
+        EXPECT_TRUE(fa.addTransition(i, 'b', i + 1));
+    }
+
+    fa::LazyDfa dfa(fa);
+    EXPECT_FALSE(dfa.match("bbbbbbbbbb"));
+    EXPECT_TRUE(dfa.match("abbbbbbbbb"));
+    EXPECT_LT(dfa.countCachedStates(), 30u);
+}
+
+TEST(LazyDfa, FlushWhenFull) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    for (int i = 0; i <= 10; ++i) {
+        EXPECT_TRUE(fa.addState(i));
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(10);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    for (int i = 1; i < 10; ++i) {
+        EXPECT_TRUE(fa.addTransition(i, 'a', i + 1));
+        EXPECT_TRUE(fa.addTransition(i, 'b', i + 1));
+    }
+
+    fa::LazyDfa dfa(fa, 2048);
+    std::string word;
+    unsigned seed = 42;
+    for (int i = 0; i < 500; ++i) {
+        seed = seed * 1103515245 + 12345;
+        word += (seed >> 16) % 2 == 0 ? 'a' : 'b';
+        EXPECT_EQ(fa.match(word), dfa.match(word));
+    }
+    EXPECT_GT(dfa.countFlushes(), 0u);
+    EXPECT_LE(dfa.memoryUsage(), 2048u);
+}
+
+// --- EPSILON ---
+TEST(AutomatonEpsilonClosure, MakeTransition) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+    EXPECT_TRUE(fa.addState(3));
+
+    EXPECT_TRUE(fa.addTransition(0, fa::Epsilon, 1));
+    EXPECT_TRUE(fa.addTransition(1, 'a', 2));
+    EXPECT_TRUE(fa.addTransition(2, fa::Epsilon, 3));
+
+    std::set<int> expected = {2, 3};
+    EXPECT_EQ(expected, fa.makeTransition({0}, 'a'));
+}
+
+TEST(AutomatonEpsilonClosure, ReadString) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+    EXPECT_TRUE(fa.addState(3));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(3);
+
+    EXPECT_TRUE(fa.addTransition(0, fa::Epsilon, 1));
+    EXPECT_TRUE(fa.addTransition(1, fa::Epsilon, 0));
+    EXPECT_TRUE(fa.addTransition(1, 'a', 2));
+    EXPECT_TRUE(fa.addTransition(2, fa::Epsilon, 3));
+    EXPECT_TRUE(fa.addTransition(3, 'b', 0));
+
+    std::set<int> expected = {0, 1};
+    EXPECT_EQ(expected, fa.readString(""));
+    expected = {2, 3};
+    EXPECT_EQ(expected, fa.readString("a"));
+
+    EXPECT_TRUE(fa.match("a"));
+    EXPECT_TRUE(fa.match("aba"));
+    EXPECT_FALSE(fa.match("ab"));
+    EXPECT_FALSE(fa.match("b"));
+}
+
+TEST(AutomatonEpsilonClosure, UpdatedAfterRemove) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+
+    EXPECT_TRUE(fa.addTransition(0, fa::Epsilon, 1));
+    EXPECT_TRUE(fa.match(""));
+
+    EXPECT_TRUE(fa.removeTransition(0, fa::Epsilon, 1));
+    EXPECT_FALSE(fa.match(""));
+}
+
+TEST(AutomatonEpsilonClosure, CreateDeterministic) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, fa::Epsilon, 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+
+    fa::Automaton dfa = fa::Automaton::createDeterministic(fa);
+    EXPECT_TRUE(dfa.isDeterministic());
+    for (std::string word : {"", "a", "b", "ab", "aab", "ba", "abb"}) {
+        EXPECT_EQ(fa.match(word), dfa.match(word));
+    }
+}
+
+TEST(AutomatonEpsilonClosure, Compiled) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+    EXPECT_TRUE(fa.addState(3));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(3);
+
+    EXPECT_TRUE(fa.addTransition(0, fa::Epsilon, 1));
+    EXPECT_TRUE(fa.addTransition(1, 'a', 2));
+    EXPECT_TRUE(fa.addTransition(2, fa::Epsilon, 0));
+    EXPECT_TRUE(fa.addTransition(2, 'b', 3));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::CompiledDfa dfa(fa);
+    fa::BitsetNfa nfa(fa);
+    fa::LazyDfa lazy(fa);
+    for (std::string word : {"", "a", "ab", "aab", "aaab", "abab", "b"}) {
+        EXPECT_EQ(fa.readString(word), compiled.readString(word));
+        EXPECT_EQ(fa.match(word), dfa.match(word));
+        EXPECT_EQ(fa.match(word), nfa.match(word));
+        EXPECT_EQ(fa.match(word), lazy.match(word));
+    }
+}
+
+TEST(AutomatonEpsilonClosure, ConcurrentQueries) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    for (int state = 0; state < 40; ++state) {
+        EXPECT_TRUE(fa.addState(state));
+    }
+    for (int state = 0; state < 40; ++state) {
+        EXPECT_TRUE(fa.addTransition(state, 'a', (state + 1) % 40));
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(39);
+
+    // every round invalidates the closures, which are then computed while
+    // several threads query the same automaton
+    for (int round = 1; round < 20; ++round) {
+        EXPECT_TRUE(fa.addTransition(round - 1, fa::Epsilon, round));
+        const fa::Automaton& shared = fa;
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&shared, &errors, round]() {
+                for (int j = 0; j < 50; ++j) {
+                    if (!shared.match(std::string(39 - round, 'a'))) ++errors;
+                    if (shared.match(std::string(38 - round, 'a'))) ++errors;
+                    fa::Automaton copy(shared);
+                    if (!copy.match(std::string(39 - round, 'a'))) ++errors;
+                    fa::CompiledAutomaton compiled(shared);
+                    if (!compiled.match(std::string(39 - round, 'a'))) ++errors;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(errors.load(), 0);
+    }
+}
+
+// --- BATCHMATCHER ---
+TEST(BatchMatcher, MatchAll) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+
+    // words ending with 'a'
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+
+    std::vector<std::string> storage;
+    for (int i = 0; i < 1000; ++i) {
+        std::string word;
+        for (int n = i; n > 0; n /= 2) {
+            word += (n % 2 == 0) ? 'a' : 'b';
+        }
+        storage.push_back(word);
+    }
+    std::vector<std::string_view> words(storage.begin(), storage.end());
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::BatchMatcher matcher(compiled, 4);
+    EXPECT_EQ(4u, matcher.countThreads());
+
+    for (int run = 0; run < 3; ++run) {
+        std::vector<bool> results = matcher.matchAll(words);
+        ASSERT_EQ(words.size(), results.size());
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            EXPECT_EQ(fa.match(storage[i]), results[i]);
+        }
+    }
+}
+
+TEST(BatchMatcher, SingleThread) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+
+    EXPECT_TRUE(fa.addState(0));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(0);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::BatchMatcher matcher(compiled, 1);
+
+    std::string_view words[] = { "", "a", "aab", "aaaa" };
+    bool results[4];
+    matcher.matchAll(words, 4, results);
+    EXPECT_TRUE(results[0]);
+    EXPECT_TRUE(results[1]);
+    EXPECT_FALSE(results[2]);
+    EXPECT_TRUE(results[3]);
+}
+
+// --- STREAMMATCHER ---
+TEST(StreamMatcher, Chunks) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    // words containing "ab"
+    EXPECT_TRUE(fa.addTransition(0, 'a', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 0));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+    EXPECT_TRUE(fa.addTransition(2, 'a', 2));
+    EXPECT_TRUE(fa.addTransition(2, 'b', 2));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::StreamMatcher matcher(compiled);
+    EXPECT_FALSE(matcher.accepting());
+
+    matcher.feed("bba");
+    EXPECT_FALSE(matcher.accepting());
+    EXPECT_EQ(fa.readString("bba"), matcher.currentStates());
+
+    matcher.feed("b");
+    EXPECT_TRUE(matcher.accepting());
+
+    matcher.feed("aaa");
+    EXPECT_TRUE(matcher.accepting());
+    EXPECT_EQ(7u, matcher.position());
+    EXPECT_EQ(fa.readString("bbabaaa"), matcher.currentStates());
+
+    matcher.reset();
+    EXPECT_EQ(0u, matcher.position());
+    EXPECT_FALSE(matcher.accepting());
+}
+
+TEST(StreamMatcher, Dead) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::StreamMatcher matcher(compiled);
+    EXPECT_FALSE(matcher.dead());
+
+    matcher.feed("a");
+    EXPECT_TRUE(matcher.accepting());
+    EXPECT_FALSE(matcher.dead());
+
+    matcher.feed("a");
+    EXPECT_FALSE(matcher.accepting());
+    EXPECT_TRUE(matcher.dead());
+}
+
+// --- SEARCHER ---
+TEST(Searcher, RequiredPrefix) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+    EXPECT_TRUE(fa.addSymbol('c'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+    EXPECT_TRUE(fa.addState(3));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(3);
+
+    // ab(a|c)
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+    EXPECT_TRUE(fa.addTransition(2, 'a', 3));
+    EXPECT_TRUE(fa.addTransition(2, 'c', 3));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::Searcher searcher(compiled);
+    EXPECT_EQ("ab", searcher.requiredPrefix());
+
+    std::optional<fa::Match> match = searcher.find("cccabbabcaab");
+    ASSERT_TRUE(match.has_value());
+    EXPECT_EQ(6u, match->start);
+    EXPECT_EQ(9u, match->end);
+
+    EXPECT_FALSE(searcher.find("cccabbabbaab").has_value());
+    EXPECT_FALSE(searcher.find("cccabbabcaab", 7).has_value());
+}
+
+TEST(Searcher, FindAll) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    // a+b
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'b', 2));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::Searcher searcher(compiled);
+    EXPECT_EQ("a", searcher.requiredPrefix());
+
+    std::vector<fa::Match> matches = searcher.findAll("bbaabxabaaab");
+    ASSERT_EQ(3u, matches.size());
+    EXPECT_EQ(2u, matches[0].start);
+    EXPECT_EQ(5u, matches[0].end);
+    EXPECT_EQ(6u, matches[1].start);
+    EXPECT_EQ(8u, matches[1].end);
+    EXPECT_EQ(8u, matches[2].start);
+    EXPECT_EQ(12u, matches[2].end);
+}
+
+TEST(Searcher, NoPrefix) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+
+    EXPECT_TRUE(fa.addTransition(0, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(0, 'b', 1));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::Searcher searcher(compiled);
+    EXPECT_EQ("", searcher.requiredPrefix());
+
+    std::vector<fa::Match> matches = searcher.findAll("xxbyya");
+    ASSERT_EQ(2u, matches.size());
+    EXPECT_EQ(2u, matches[0].start);
+    EXPECT_EQ(5u, matches[1].start);
+    EXPECT_EQ(6u, matches[1].end);
+}
+
+TEST(Searcher, EmptyWord) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+
+    EXPECT_TRUE(fa.addState(0));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(0);
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::Searcher searcher(compiled);
+
+    std::optional<fa::Match> match = searcher.find("bb", 1);
+    ASSERT_TRUE(match.has_value());
+    EXPECT_EQ(1u, match->start);
+    EXPECT_EQ(1u, match->end);
+    EXPECT_EQ(3u, searcher.findAll("bb").size());
+}
+
+TEST(Searcher, StartsOfActiveStates) {
+    fa::Automaton fa;
+
+    EXPECT_TRUE(fa.addSymbol('a'));
+    EXPECT_TRUE(fa.addSymbol('b'));
+    EXPECT_TRUE(fa.addSymbol('c'));
+
+    EXPECT_TRUE(fa.addState(0));
+    EXPECT_TRUE(fa.addState(1));
+    EXPECT_TRUE(fa.addState(2));
+    EXPECT_TRUE(fa.addState(3));
+
+    fa.setStateInitial(0);
+    fa.setStateFinal(3);
+
+    EXPECT_TRUE(fa.addTransition(0, 'b', 1));
+    EXPECT_TRUE(fa.addTransition(1, 'a', 1));
+    EXPECT_TRUE(fa.addTransition(0, 'a', 2));
+    EXPECT_TRUE(fa.addTransition(1, 'c', 2));
+    EXPECT_TRUE(fa.addTransition(2, 'c', 3));
+
+    fa::CompiledAutomaton compiled(fa);
+    fa::Searcher searcher(compiled);
+
+    // after "ba", state 1 (started at 0) reaches state 2 (started at 1)
+    // before state 2 is expanded: its start must not leak into 3
+    EXPECT_FALSE(fa.match("bac"));
+    EXPECT_TRUE(fa.match("ac"));
+    std::optional<fa::Match> match = searcher.find("bac");
+    ASSERT_TRUE(match.has_value());
+    EXPECT_EQ(1u, match->start);
+    EXPECT_EQ(3u, match->end);
+}
+
+TEST(Searcher, SameAsSubstrings) {
+    std::mt19937 random(2024);
+    const std::string symbols = { 'a', 'b', 'c', fa::Epsilon };
+
+    for (int round = 0; round < 300; ++round) {
+        fa::Automaton fa;
+        EXPECT_TRUE(fa.addSymbol('a'));
+        EXPECT_TRUE(fa.addSymbol('b'));
+        EXPECT_TRUE(fa.addSymbol('c'));
+        int n = 2 + random() % 5;
+        for (int state = 0; state < n; ++state) {
+            EXPECT_TRUE(fa.addState(state));
+        }
+        fa.setStateInitial(0);
+        fa.setStateFinal(n - 1);
+        int count = random() % (3 * n);
+        for (int i = 0; i < count; ++i) {
+            fa.addTransition(random() % n, symbols[random() % symbols.size()], random() % n);
+        }
+
+        std::string text;
+        for (int i = 0; i < 12; ++i) {
+            text.push_back(symbols[random() % 3]);
+        }
+
+        // the first match ends first, then starts first
+        auto bruteFind = [&fa, &text](std::size_t from) -> std::optional<fa::Match> {
+            for (std::size_t end = from; end <= text.size(); ++end) {
+                for (std::size_t start = from; start <= end; ++start) {
+                    if (fa.match(text.substr(start, end - start))) {
+                        return fa::Match{ start, end };
+                    }
+                }
+            }
+            return std::nullopt;
+        };
+
+        fa::CompiledAutomaton compiled(fa);
+        fa::Searcher searcher(compiled);
+        for (std::size_t from = 0; from <= text.size(); ++from) {
+            std::optional<fa::Match> expected = bruteFind(from);
+            std::optional<fa::Match> match = searcher.find(text, from);
+            ASSERT_EQ(expected.has_value(), match.has_value()) << text << " from " << from;
+            if (expected) {
+                EXPECT_EQ(expected->start, match->start) << text << " from " << from;
+                EXPECT_EQ(expected->end, match->end) << text << " from " << from;
+            }
+        }
+
+        std::vector<fa::Match> expected;
+        for (std::size_t from = 0; ; ) {
+            std::optional<fa::Match> match = bruteFind(from);
+            if (!match) break;
+            expected.push_back(*match);
+            from = match->end > match->start ? match->end : match->end + 1;
+        }
+        std::vector<fa::Match> matches = searcher.findAll(text);
+        ASSERT_EQ(expected.size(), matches.size()) << text;
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            EXPECT_EQ(expected[i].start, matches[i].start) << text;
+            EXPECT_EQ(expected[i].end, matches[i].end) << text;
+        }
+    }
+}
+
+// --- DENSE STATES ---
+
+TEST(AutomatonDenseStates, RemoveStateKeepsOthers) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addSymbol('b');
+    for (int state = 0; state < 50; ++state) {
+        EXPECT_TRUE(fa.addState(state * 3));
+    }
+    for (int state = 0; state < 49; ++state) {
+        EXPECT_TRUE(fa.addTransition(state * 3, 'a', state * 3 + 3));
+        EXPECT_TRUE(fa.addTransition(state * 3, 'b', 0));
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(147);
+
+    // the last state is moved into the hole: its transitions must follow it
+    EXPECT_TRUE(fa.removeState(60));
+    EXPECT_FALSE(fa.hasState(60));
+    EXPECT_EQ(fa.countStates(), 49u);
+    EXPECT_EQ(fa.countTransitions(), 98u - 3u);
+    EXPECT_TRUE(fa.isStateFinal(147));
+    EXPECT_TRUE(fa.hasTransition(144, 'a', 147));
+    EXPECT_TRUE(fa.hasTransition(147 - 3, 'b', 0));
+    EXPECT_FALSE(fa.hasTransition(57, 'a', 60));
+    EXPECT_EQ(fa.readString(std::string(19, 'a')), std::set<int>({ 57 }));
+    EXPECT_FALSE(fa.match(std::string(49, 'a')));
+
+    EXPECT_TRUE(fa.addState(60));
+    EXPECT_TRUE(fa.addTransition(57, 'a', 60));
+    EXPECT_TRUE(fa.addTransition(60, 'a', 63));
+    EXPECT_TRUE(fa.match(std::string(49, 'a')));
+    EXPECT_EQ(fa.countTransitions(), 97u);
+}
+
+TEST(AutomatonDenseStates, RemoveStateCountsRemovedEdges) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.addState(1);
+    fa.addState(2);
+    fa.setStateInitial(0);
+    fa.addTransition(0, fa::Epsilon, 1);
+    fa.addTransition(0, 'a', 2);
+    EXPECT_FALSE(fa.isDeterministic());
+
+    // the epsilon-transition is removed, not the one that takes its place
+    EXPECT_TRUE(fa.removeState(1));
+    EXPECT_EQ(fa.countTransitions(), 1u);
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_TRUE(fa.hasTransition(0, 'a', 2));
+    EXPECT_TRUE(fa.isDeterministic());
+}
+
+TEST(AutomatonDenseStates, RemoveNonAccessibleStatesCounts) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    for (int state = 0; state < 10; ++state) {
+        fa.addState(state);
+        fa.addTransition(state, 'a', state);
+    }
+    fa.addTransition(0, fa::Epsilon, 2);
+    fa.addTransition(2, 'a', 4);
+    fa.addTransition(5, fa::Epsilon, 4);
+    fa.setStateInitial(0);
+    fa.setStateFinal(4);
+    fa.setStateFinal(9);
+
+    fa.removeNonAccessibleStates();
+    EXPECT_EQ(fa.countStates(), 3u);
+    EXPECT_EQ(fa.countTransitions(), 5u);
+    EXPECT_TRUE(fa.hasEpsilonTransition());
+    EXPECT_TRUE(fa.hasTransition(2, 'a', 4));
+    EXPECT_TRUE(fa.match("a"));
+    EXPECT_FALSE(fa.match(""));
+
+    fa.removeTransition(0, fa::Epsilon, 2);
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_FALSE(fa.match("a"));
+}
+
+// --- MINIMIZATION ---
+
+namespace {
+
+    // (a|b)*a(a|b)^k: the minimal automaton has 2^(k+1) states
+    fa::Automaton createKthFromEnd(int k) {
+        fa::Automaton fa;
+        fa.addSymbol('a');
+        fa.addSymbol('b');
+        for (int state = 0; state <= k + 1; ++state) {
+            fa.addState(state);
+        }
+        fa.setStateInitial(0);
+        fa.setStateFinal(k + 1);
+        fa.addTransition(0, 'a', 0);
+        fa.addTransition(0, 'b', 0);
+        fa.addTransition(0, 'a', 1);
+        for (int state = 1; state <= k; ++state) {
+            fa.addTransition(state, 'a', state + 1);
+            fa.addTransition(state, 'b', state + 1);
+        }
+        return fa;
+    }
+
+    void expectSameLanguage(const fa::Automaton& lhs, const fa::Automaton& rhs, std::size_t length) {
+        for (std::size_t size = 0; size <= length; ++size) {
+            for (std::size_t bits = 0; bits < (std::size_t(1) << size); ++bits) {
+                std::string word;
+                for (std::size_t i = 0; i < size; ++i) {
+                    word.push_back((bits >> i) & 1 ? 'b' : 'a');
+                }
+                EXPECT_EQ(lhs.match(word), rhs.match(word)) << word;
+            }
+        }
+    }
+
+}
+
+TEST(AutomatonMinimal, KthFromEnd) {
+    fa::Automaton fa = createKthFromEnd(3);
+    fa::Automaton moore = fa::Automaton::createMinimalMoore(fa);
+    fa::Automaton hopcroft = fa::Automaton::createMinimalHopcroft(fa);
+
+    EXPECT_TRUE(moore.isDeterministic());
+    EXPECT_TRUE(hopcroft.isDeterministic());
+    EXPECT_EQ(moore.countStates(), 16u);
+    EXPECT_EQ(hopcroft.countStates(), 16u);
+    expectSameLanguage(fa, moore, 8);
+    expectSameLanguage(fa, hopcroft, 8);
+}
+
+TEST(AutomatonMinimal, IncompleteWithoutSink) {
+    // ab|cb, written with redundant states and a useless branch
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addSymbol('b');
+    fa.addSymbol('c');
+    for (int state = 0; state < 7; ++state) {
+        fa.addState(state);
+    }
+    fa.setStateInitial(0);
+    fa.addTransition(0, 'a', 1);
+    fa.addTransition(0, 'c', 2);
+    fa.addTransition(1, 'b', 3);
+    fa.addTransition(2, 'b', 4);
+    fa.addTransition(1, 'a', 5);
+    fa.addTransition(5, 'a', 6);
+    fa.setStateFinal(3);
+    fa.setStateFinal(4);
+    ASSERT_TRUE(fa.isDeterministic());
+    ASSERT_FALSE(fa.isComplete());
+
+    fa::Automaton moore = fa::Automaton::createMinimalMoore(fa);
+    fa::Automaton hopcroft = fa::Automaton::createMinimalHopcroft(fa);
+    EXPECT_EQ(moore.countStates(), 3u);
+    EXPECT_EQ(moore.countTransitions(), 3u);
+    EXPECT_EQ(hopcroft.countStates(), 3u);
+    EXPECT_EQ(hopcroft.countTransitions(), 3u);
+    EXPECT_TRUE(hopcroft.match("ab"));
+    EXPECT_TRUE(hopcroft.match("cb"));
+    EXPECT_FALSE(hopcroft.match("aa"));
+    EXPECT_FALSE(hopcroft.match("b"));
+}
+
+TEST(AutomatonMinimal, EmptyLanguage) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.addState(1);
+    fa.setStateInitial(0);
+    fa.addTransition(0, 'a', 1);
+    fa.addTransition(1, 'a', 0);
+
+    fa::Automaton hopcroft = fa::Automaton::createMinimalHopcroft(fa);
+    EXPECT_EQ(hopcroft.countStates(), 1u);
+    EXPECT_EQ(hopcroft.countTransitions(), 0u);
+    EXPECT_TRUE(hopcroft.isLanguageEmpty());
+    EXPECT_EQ(fa::Automaton::createMinimalMoore(fa).countStates(), 1u);
+}
+
+TEST(AutomatonMinimal, SameResult) {
+    fa::Automaton fa = createKthFromEnd(2);
+    fa.addTransition(3, fa::Epsilon, 0);
+    fa::Automaton moore = fa::Automaton::createMinimalMoore(fa);
+    fa::Automaton hopcroft = fa::Automaton::createMinimalHopcroft(fa);
+
+    // both are numbered in breadth-first order, so they are identical
+    ASSERT_EQ(moore.countStates(), hopcroft.countStates());
+    ASSERT_EQ(moore.countTransitions(), hopcroft.countTransitions());
+    for (int state = 0; state < static_cast<int>(moore.countStates()); ++state) {
+        EXPECT_EQ(moore.isStateFinal(state), hopcroft.isStateFinal(state));
+        for (char c : { 'a', 'b' }) {
+            EXPECT_EQ(moore.makeTransition({ state }, c), hopcroft.makeTransition({ state }, c));
+        }
+    }
+    expectSameLanguage(fa, hopcroft, 8);
+}
+
+TEST(AutomatonMinimal, Brzozowski) {
+    fa::Automaton fa = createKthFromEnd(3);
+    fa::Automaton::BrzozowskiStats stats;
+    fa::Automaton brzozowski = fa::Automaton::createMinimalBrzozowski(fa, stats);
+
+    EXPECT_TRUE(brzozowski.isDeterministic());
+    EXPECT_EQ(brzozowski.countStates(), 16u);
+    expectSameLanguage(fa, brzozowski, 8);
+
+    // the mirror language is a(a|b)^3(a|b)*, its automaton stays small
+    EXPECT_EQ(stats.intermediateStates, 5u);
+    EXPECT_EQ(stats.intermediateTransitions, 9u);
+    EXPECT_EQ(stats.largestSubset, 5u);
+}
+
+TEST(AutomatonMinimal, BrzozowskiSameAsHopcroft) {
+    fa::Automaton fa = createKthFromEnd(2);
+    fa.addTransition(3, fa::Epsilon, 1);
+    fa.addState(10);
+    fa.setStateInitial(10);
+    fa.addTransition(10, 'b', 2);
+
+    fa::Automaton brzozowski = fa::Automaton::createMinimalBrzozowski(fa);
+    fa::Automaton hopcroft = fa::Automaton::createMinimalHopcroft(fa);
+    ASSERT_EQ(brzozowski.countStates(), hopcroft.countStates());
+    ASSERT_EQ(brzozowski.countTransitions(), hopcroft.countTransitions());
+    for (int state = 0; state < static_cast<int>(brzozowski.countStates()); ++state) {
+        EXPECT_EQ(brzozowski.isStateFinal(state), hopcroft.isStateFinal(state));
+        for (char c : { 'a', 'b' }) {
+            EXPECT_EQ(brzozowski.makeTransition({ state }, c), hopcroft.makeTransition({ state }, c));
+        }
+    }
+    expectSameLanguage(fa, brzozowski, 8);
+}
+
+TEST(AutomatonMinimal, BrzozowskiEmptyLanguage) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.setStateInitial(0);
+    fa.addTransition(0, 'a', 0);
+
+    fa::Automaton brzozowski = fa::Automaton::createMinimalBrzozowski(fa);
+    EXPECT_EQ(brzozowski.countStates(), 1u);
+    EXPECT_EQ(brzozowski.countTransitions(), 0u);
+    EXPECT_TRUE(brzozowski.isStateInitial(0));
+    EXPECT_TRUE(brzozowski.isLanguageEmpty());
+}
+
+// --- INCLUSION ---
+
+TEST(AutomatonIsIncludedIn, Included) {
+    fa::Automaton lhs = createKthFromEnd(2);
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addSymbol('b');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.setStateInitial(0);
+    rhs.setStateFinal(1);
+    rhs.addTransition(0, 'a', 0);
+    rhs.addTransition(0, 'b', 0);
+    rhs.addTransition(0, 'a', 1);
+    rhs.addTransition(0, 'b', 1);
+
+    std::string counterexample = "unchanged";
+    EXPECT_TRUE(lhs.isIncludedIn(rhs, counterexample));
+    EXPECT_EQ(counterexample, "unchanged");
+    EXPECT_TRUE(lhs.isIncludedIn(lhs));
+
+    EXPECT_FALSE(rhs.isIncludedIn(lhs, counterexample));
+    EXPECT_EQ(counterexample.size(), 1u);
+    EXPECT_TRUE(rhs.match(counterexample));
+    EXPECT_FALSE(lhs.match(counterexample));
+}
+
+TEST(AutomatonIsIncludedIn, ExponentialComplement) {
+    // the complement of the right automaton has 2^17 states, but a short
+    // counterexample is found without building it
+    fa::Automaton lhs = createKthFromEnd(16);
+    fa::Automaton rhs = createKthFromEnd(15);
+
+    std::string counterexample;
+    EXPECT_FALSE(lhs.isIncludedIn(rhs, counterexample));
+    EXPECT_TRUE(lhs.match(counterexample));
+    EXPECT_FALSE(rhs.match(counterexample));
+    EXPECT_EQ(counterexample.size(), 17u);
+    EXPECT_TRUE(lhs.isIncludedIn(lhs));
+}
+
+TEST(AutomatonIsIncludedIn, OtherAlphabet) {
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addSymbol('c');
+    lhs.addState(0);
+    lhs.addState(1);
+    lhs.setStateInitial(0);
+    lhs.setStateFinal(1);
+    lhs.addTransition(0, 'a', 0);
+    lhs.addTransition(0, 'c', 1);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addState(0);
+    rhs.setStateInitial(0);
+    rhs.setStateFinal(0);
+    rhs.addTransition(0, 'a', 0);
+
+    std::string counterexample;
+    EXPECT_FALSE(lhs.isIncludedIn(rhs, counterexample));
+    EXPECT_EQ(counterexample, "c");
+    EXPECT_FALSE(rhs.isIncludedIn(lhs, counterexample));
+    EXPECT_EQ(counterexample, "");
+}
+
+TEST(AutomatonIsIncludedIn, Epsilon) {
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addState(0);
+    lhs.addState(1);
+    lhs.setStateInitial(0);
+    lhs.setStateFinal(1);
+    lhs.addTransition(0, 'a', 1);
+    lhs.addTransition(1, fa::Epsilon, 0);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.setStateInitial(0);
+    rhs.setStateFinal(1);
+    rhs.addTransition(0, 'a', 1);
+    rhs.addTransition(1, 'a', 1);
+
+    EXPECT_TRUE(lhs.isIncludedIn(rhs));
+    EXPECT_TRUE(rhs.isIncludedIn(lhs));
+}
+
+// --- EQUIVALENCE ---
+
+TEST(AutomatonIsEquivalentTo, Minimal) {
+    fa::Automaton fa = createKthFromEnd(4);
+    fa::Automaton minimal = fa::Automaton::createMinimalHopcroft(fa);
+
+    std::string counterexample = "unchanged";
+    EXPECT_TRUE(fa.isEquivalentTo(minimal, counterexample));
+    EXPECT_TRUE(minimal.isEquivalentTo(fa, counterexample));
+    EXPECT_TRUE(minimal.isEquivalentTo(minimal, counterexample));
+    EXPECT_EQ(counterexample, "unchanged");
+}
+
+TEST(AutomatonIsEquivalentTo, ShortestCounterexample) {
+    fa::Automaton lhs = createKthFromEnd(4);
+    fa::Automaton rhs = createKthFromEnd(4);
+    rhs.addState(10);
+    rhs.addTransition(3, 'b', 10);
+    rhs.addTransition(10, 'b', 10);
+    rhs.setStateFinal(10);
+
+    std::string counterexample;
+    EXPECT_FALSE(lhs.isEquivalentTo(rhs, counterexample));
+    EXPECT_EQ(counterexample, "aaab");
+    EXPECT_FALSE(rhs.isEquivalentTo(lhs, counterexample));
+    EXPECT_EQ(counterexample, "aaab");
+}
+
+TEST(AutomatonIsEquivalentTo, EmptyWord) {
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addState(0);
+    lhs.setStateInitial(0);
+    lhs.addTransition(0, 'a', 0);
+
+    fa::Automaton rhs = lhs;
+    rhs.setStateFinal(0);
+
+    std::string counterexample = "unchanged";
+    EXPECT_FALSE(lhs.isEquivalentTo(rhs, counterexample));
+    EXPECT_EQ(counterexample, "");
+}
+
+TEST(AutomatonIsEquivalentTo, DifferentAlphabets) {
+    // a* written over {a} and over {a, b}
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addState(0);
+    lhs.setStateInitial(0);
+    lhs.setStateFinal(0);
+    lhs.addTransition(0, 'a', 0);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addSymbol('b');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.setStateInitial(0);
+    rhs.setStateFinal(1);
+    rhs.addTransition(0, fa::Epsilon, 1);
+    rhs.addTransition(1, 'a', 0);
+
+    EXPECT_TRUE(lhs.isEquivalentTo(rhs));
+
+    std::string counterexample;
+    rhs.addTransition(1, 'b', 1);
+    EXPECT_FALSE(lhs.isEquivalentTo(rhs, counterexample));
+    EXPECT_EQ(counterexample, "b");
+}
+
+// --- INTERSECTION ---
+
+TEST(AutomatonHasEmptyIntersectionWith, Nondeterministic) {
+    // the second initial state and the second successor are needed
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addSymbol('b');
+    for (int state = 0; state < 4; ++state) {
+        lhs.addState(state);
+    }
+    lhs.setStateInitial(0);
+    lhs.setStateInitial(1);
+    lhs.addTransition(1, 'a', 2);
+    lhs.addTransition(1, 'a', 3);
+    lhs.addTransition(3, 'b', 3);
+    lhs.setStateFinal(3);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addSymbol('b');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.setStateInitial(0);
+    rhs.addTransition(0, 'a', 1);
+    rhs.addTransition(1, 'b', 1);
+    rhs.setStateFinal(1);
+
+    EXPECT_FALSE(lhs.hasEmptyIntersectionWith(rhs));
+    EXPECT_FALSE(rhs.hasEmptyIntersectionWith(lhs));
+
+    rhs.removeTransition(1, 'b', 1);
+    rhs.addTransition(1, 'a', 1);
+    EXPECT_FALSE(lhs.hasEmptyIntersectionWith(rhs));
+    rhs.setStateFinal(0);
+    rhs.removeState(1);
+    EXPECT_TRUE(lhs.hasEmptyIntersectionWith(rhs));
+}
+
+TEST(AutomatonHasEmptyIntersectionWith, Epsilon) {
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addState(0);
+    lhs.addState(1);
+    lhs.addState(2);
+    lhs.setStateInitial(0);
+    lhs.addTransition(0, fa::Epsilon, 1);
+    lhs.addTransition(1, 'a', 2);
+    lhs.addTransition(2, fa::Epsilon, 0);
+    lhs.setStateFinal(2);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.addState(2);
+    rhs.setStateInitial(0);
+    rhs.addTransition(0, 'a', 1);
+    rhs.addTransition(1, 'a', 2);
+    rhs.setStateFinal(2);
+
+    EXPECT_FALSE(lhs.hasEmptyIntersectionWith(rhs));
+    lhs.removeTransition(2, fa::Epsilon, 0);
+    EXPECT_TRUE(lhs.hasEmptyIntersectionWith(rhs));
+}
+
+TEST(AutomatonHasEmptyIntersectionWith, DisjointAlphabets) {
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addState(0);
+    lhs.setStateInitial(0);
+    lhs.setStateFinal(0);
+    lhs.addTransition(0, 'a', 0);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('b');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.setStateInitial(0);
+    rhs.setStateFinal(1);
+    rhs.addTransition(0, 'b', 1);
+
+    EXPECT_TRUE(lhs.hasEmptyIntersectionWith(rhs));
+    rhs.setStateFinal(0);
+    EXPECT_FALSE(lhs.hasEmptyIntersectionWith(rhs));
+}
+
+TEST(AutomatonCreateIntersection, Nondeterministic) {
+    // ab* with two initial states and two successors on 'a', against a+b
+    fa::Automaton lhs;
+    lhs.addSymbol('a');
+    lhs.addSymbol('b');
+    for (int state = 0; state < 4; ++state) {
+        lhs.addState(state);
+    }
+    lhs.setStateInitial(0);
+    lhs.setStateInitial(1);
+    lhs.addTransition(1, 'a', 2);
+    lhs.addTransition(1, 'a', 3);
+    lhs.addTransition(3, 'b', 3);
+    lhs.setStateFinal(3);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addSymbol('b');
+    rhs.addSymbol('c');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.addState(2);
+    rhs.setStateInitial(0);
+    rhs.addTransition(0, 'a', 1);
+    rhs.addTransition(1, 'a', 1);
+    rhs.addTransition(1, 'b', 2);
+    rhs.addTransition(1, 'c', 2);
+    rhs.setStateFinal(2);
+
+    fa::Automaton product = fa::Automaton::createIntersection(lhs, rhs);
+    EXPECT_EQ(product.countSymbols(), 2u);
+    EXPECT_TRUE(product.match("ab"));
+    EXPECT_FALSE(product.match("a"));
+    EXPECT_FALSE(product.match("aab"));
+    EXPECT_FALSE(product.match("abb"));
+    EXPECT_FALSE(product.isLanguageEmpty());
+}
+
+TEST(AutomatonCreateIntersection, Epsilon) {
+    fa::Automaton lhs = createKthFromEnd(1);
+    lhs.addTransition(2, fa::Epsilon, 0);
+
+    fa::Automaton rhs;
+    rhs.addSymbol('a');
+    rhs.addSymbol('b');
+    rhs.addState(0);
+    rhs.addState(1);
+    rhs.setStateInitial(0);
+    rhs.setStateFinal(0);
+    rhs.addTransition(0, 'a', 1);
+    rhs.addTransition(0, 'b', 1);
+    rhs.addTransition(1, 'a', 0);
+    rhs.addTransition(1, 'b', 0);
+
+    // words of even length whose letter before the last is 'a'
+    fa::Automaton product = fa::Automaton::createIntersection(lhs, rhs);
+    EXPECT_FALSE(product.hasEpsilonTransition());
+    for (std::size_t size = 0; size <= 8; ++size) {
+        for (std::size_t bits = 0; bits < (std::size_t(1) << size); ++bits) {
+            std::string word;
+            for (std::size_t i = 0; i < size; ++i) {
+                word.push_back((bits >> i) & 1 ? 'b' : 'a');
+            }
+            EXPECT_EQ(product.match(word), lhs.match(word) && rhs.match(word)) << word;
+        }
+    }
+}
+
+TEST(AutomatonCreateDeterministic, ManySubsets) {
+    fa::Automaton fa = createKthFromEnd(13);
+    fa::Automaton dfa = fa::Automaton::createDeterministic(fa);
+
+    EXPECT_TRUE(dfa.isDeterministic());
+    EXPECT_TRUE(dfa.isComplete());
+    EXPECT_EQ(dfa.countStates(), 16384u);
+    EXPECT_EQ(dfa.countTransitions(), 32768u);
+    EXPECT_TRUE(dfa.isStateInitial(0));
+    EXPECT_TRUE(dfa.match("a" + std::string(13, 'b')));
+    EXPECT_FALSE(dfa.match("b" + std::string(13, 'a')));
+}
+
+namespace {
+
+    void expectSameAutomaton(const fa::Automaton& lhs, const fa::Automaton& rhs, const std::string& symbols) {
+        ASSERT_EQ(lhs.countStates(), rhs.countStates());
+        ASSERT_EQ(lhs.countTransitions(), rhs.countTransitions());
+        for (int state = 0; state < static_cast<int>(lhs.countStates()); ++state) {
+            EXPECT_EQ(lhs.isStateInitial(state), rhs.isStateInitial(state));
+            EXPECT_EQ(lhs.isStateFinal(state), rhs.isStateFinal(state));
+            for (char c : symbols) {
+                EXPECT_EQ(lhs.makeTransition({ state }, c), rhs.makeTransition({ state }, c));
+            }
+        }
+    }
+
+}
+
+TEST(AutomatonCreateDeterministic, Parallel) {
+    fa::Automaton fa = createKthFromEnd(13);
+    fa::Automaton sequential = fa::Automaton::createDeterministic(fa);
+    fa::Automaton parallel = fa::Automaton::createDeterministic(fa, 4);
+
+    EXPECT_TRUE(parallel.isDeterministic());
+    expectSameAutomaton(sequential, parallel, "ab");
+}
+
+TEST(AutomatonCreateDeterministic, ParallelEpsilon) {
+    fa::Automaton fa = createKthFromEnd(10);
+    fa.addSymbol('c');
+    fa.addTransition(4, fa::Epsilon, 0);
+    fa.addTransition(7, 'c', 2);
+    fa.addTransition(9, fa::Epsilon, 3);
+
+    expectSameAutomaton(fa::Automaton::createDeterministic(fa), fa::Automaton::createDeterministic(fa, 3), "abc");
+    expectSameAutomaton(fa::Automaton::createDeterministic(fa), fa::Automaton::createDeterministic(fa, 0), "abc");
+}
+
+// --- SORTED WORDS ---
+
+TEST(AutomatonCreateFromSortedWords, Minimal) {
+    std::vector<std::string> words = { "tap", "taps", "top", "tops" };
+    fa::Automaton fa = fa::Automaton::createFromSortedWords(words);
+
+    EXPECT_TRUE(fa.isDeterministic());
+    EXPECT_EQ(fa.countSymbols(), 5u);
+    EXPECT_EQ(fa.countStates(), 5u);
+    EXPECT_EQ(fa.countTransitions(), 5u);
+    for (const auto& word : words) {
+        EXPECT_TRUE(fa.match(word)) << word;
+    }
+    EXPECT_FALSE(fa.match(""));
+    EXPECT_FALSE(fa.match("ta"));
+    EXPECT_FALSE(fa.match("tapss"));
+    EXPECT_EQ(fa::Automaton::createMinimalHopcroft(fa).countStates(), fa.countStates());
+}
+
+TEST(AutomatonCreateFromSortedWords, EmptyWordAndDuplicates) {
+    const char* words[] = { "", "a", "a", "ab", "b" };
+    fa::Automaton fa = fa::Automaton::createFromSortedWords(words);
+
+    EXPECT_TRUE(fa.match(""));
+    EXPECT_TRUE(fa.match("a"));
+    EXPECT_TRUE(fa.match("ab"));
+    EXPECT_TRUE(fa.match("b"));
+    EXPECT_FALSE(fa.match("ba"));
+    EXPECT_EQ(fa.countStates(), 3u);
+}
+
+TEST(AutomatonCreateFromSortedWords, Numbers) {
+    std::vector<std::string> words;
+    for (int i = 0; i < 1000; ++i) {
+        words.push_back(std::to_string(i));
+    }
+    std::sort(words.begin(), words.end());
+    fa::Automaton fa = fa::Automaton::createFromSortedWords(words);
+
+    // [1-9]?[0-9]?[0-9] without the leading zeros
+    EXPECT_EQ(fa.countStates(), 4u);
+    EXPECT_TRUE(fa.match("0"));
+    EXPECT_TRUE(fa.match("999"));
+    EXPECT_FALSE(fa.match("01"));
+    EXPECT_FALSE(fa.match("1000"));
+    EXPECT_TRUE(fa.isEquivalentTo(fa::Automaton::createMinimalHopcroft(fa)));
+}
+
+TEST(AutomatonCreateFromSortedWords, Invalid) {
+    std::vector<std::string> unsorted = { "b", "a" };
+    EXPECT_THROW(fa::Automaton::createFromSortedWords(unsorted), std::invalid_argument);
+    std::vector<std::string> blank = { "a b" };
+    EXPECT_THROW(fa::Automaton::createFromSortedWords(blank), std::invalid_argument);
+}
+
+// --- UNION, CONCATENATION, STAR ---
+
+namespace {
+
+    // a single word
+    fa::Automaton createWord(const std::string& word, int first) {
+        fa::Automaton fa;
+        for (char c : word) {
+            fa.addSymbol(c);
+        }
+        for (std::size_t i = 0; i <= word.size(); ++i) {
+            fa.addState(first + i);
+        }
+        for (std::size_t i = 0; i < word.size(); ++i) {
+            fa.addTransition(first + i, word[i], first + i + 1);
+        }
+        fa.setStateInitial(first);
+        fa.setStateFinal(first + word.size());
+        return fa;
+    }
+
+}
+
+TEST(AutomatonCreateUnion, Words) {
+    fa::Automaton fa = fa::Automaton::createUnion(createWord("ab", 10), createWord("ba", 10));
+
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_EQ(fa.countStates(), 6u);
+    EXPECT_EQ(fa.countTransitions(), 4u);
+    EXPECT_TRUE(fa.hasState(0));
+    EXPECT_TRUE(fa.hasState(5));
+    EXPECT_TRUE(fa.match("ab"));
+    EXPECT_TRUE(fa.match("ba"));
+    EXPECT_FALSE(fa.match("aa"));
+    EXPECT_FALSE(fa.match(""));
+}
+
+TEST(AutomatonCreateConcatenation, EmptyWords) {
+    // (a|) then (b|)
+    fa::Automaton lhs = createWord("a", 0);
+    lhs.setStateFinal(0);
+    fa::Automaton rhs = createWord("b", 0);
+    rhs.addTransition(0, fa::Epsilon, 1);
+
+    fa::Automaton fa = fa::Automaton::createConcatenation(lhs, rhs);
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_EQ(fa.countStates(), 4u);
+    EXPECT_TRUE(fa.match(""));
+    EXPECT_TRUE(fa.match("a"));
+    EXPECT_TRUE(fa.match("b"));
+    EXPECT_TRUE(fa.match("ab"));
+    EXPECT_FALSE(fa.match("ba"));
+    EXPECT_FALSE(fa.match("abb"));
+}
+
+TEST(AutomatonCreateKleeneStar, Word) {
+    fa::Automaton fa = fa::Automaton::createKleeneStar(createWord("ab", 3));
+
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_EQ(fa.countStates(), 4u);
+    EXPECT_TRUE(fa.match(""));
+    EXPECT_TRUE(fa.match("ab"));
+    EXPECT_TRUE(fa.match("ababab"));
+    EXPECT_FALSE(fa.match("a"));
+    EXPECT_FALSE(fa.match("aba"));
+}
+
+TEST(AutomatonCreateKleeneStar, InitialNotFinal) {
+    // a loop on the initial state must not accept more words with the star
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addSymbol('b');
+    fa.addState(0);
+    fa.addState(1);
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+    fa.addTransition(0, 'a', 0);
+    fa.addTransition(0, 'b', 1);
+
+    fa::Automaton star = fa::Automaton::createKleeneStar(fa);
+    EXPECT_TRUE(star.match(""));
+    EXPECT_TRUE(star.match("aabab"));
+    EXPECT_FALSE(star.match("a"));
+    EXPECT_FALSE(star.match("aba"));
+}
+
+// --- REGULAR EXPRESSIONS ---
+
+TEST(AutomatonCreateFromRegex, Glushkov) {
+    fa::Automaton fa = fa::Automaton::createFromRegex("(a|b)*abb");
+
+    // one state per position, plus the initial state
+    EXPECT_EQ(fa.countStates(), 6u);
+    EXPECT_EQ(fa.countSymbols(), 2u);
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_TRUE(fa.match("abb"));
+    EXPECT_TRUE(fa.match("babaabb"));
+    EXPECT_FALSE(fa.match("ab"));
+    EXPECT_FALSE(fa.match("abba"));
+    EXPECT_EQ(fa::Automaton::createMinimalHopcroft(fa).countStates(), 4u);
+}
+
+TEST(AutomatonCreateFromRegex, Operators) {
+    fa::Automaton fa = fa::Automaton::createFromRegex("x[a-c0]+y?|()");
+
+    EXPECT_EQ(fa.countStates(), 4u);
+    EXPECT_EQ(fa.countSymbols(), 6u);
+    EXPECT_TRUE(fa.match(""));
+    EXPECT_TRUE(fa.match("xa"));
+    EXPECT_TRUE(fa.match("xc0by"));
+    EXPECT_FALSE(fa.match("x"));
+    EXPECT_FALSE(fa.match("xdy"));
+    EXPECT_FALSE(fa.match("xayy"));
+}
+
+TEST(AutomatonCreateFromRegex, Escapes) {
+    fa::Automaton fa = fa::Automaton::createFromRegex("\\(a\\*\\)[\\]\\-]");
+
+    EXPECT_TRUE(fa.match("(a*)]"));
+    EXPECT_TRUE(fa.match("(a*)-"));
+    EXPECT_FALSE(fa.match("(aa)]"));
+}
+
+TEST(AutomatonCreateFromRegex, Invalid) {
+    EXPECT_THROW(fa::Automaton::createFromRegex("(a"), std::invalid_argument);
+    EXPECT_THROW(fa::Automaton::createFromRegex("a)"), std::invalid_argument);
+    EXPECT_THROW(fa::Automaton::createFromRegex("*a"), std::invalid_argument);
+    EXPECT_THROW(fa::Automaton::createFromRegex("[]"), std::invalid_argument);
+    EXPECT_THROW(fa::Automaton::createFromRegex("[z-a]"), std::invalid_argument);
+    EXPECT_THROW(fa::Automaton::createFromRegex("a b"), std::invalid_argument);
+    EXPECT_THROW(fa::Automaton::createFromRegex("a\\"), std::invalid_argument);
+}
+
+// --- IN-PLACE OPERATIONS ---
+
+TEST(AutomatonInPlace, MakeComplete) {
+    fa::Automaton fa = createWord("ab", 0);
+    fa.makeComplete();
+
+    EXPECT_TRUE(fa.isComplete());
+    EXPECT_EQ(fa.countStates(), 4u);
+    EXPECT_EQ(fa.countTransitions(), 8u);
+    EXPECT_TRUE(fa.match("ab"));
+    EXPECT_FALSE(fa.match("ba"));
+
+    fa.makeComplete();
+    EXPECT_EQ(fa.countStates(), 4u);
+}
+
+TEST(AutomatonInPlace, ComplementAndDeterminize) {
+    fa::Automaton fa = createKthFromEnd(2);
+    fa::Automaton reference = fa::Automaton::createComplement(fa);
+
+    fa::Automaton copy = fa;
+    copy.determinizeInPlace();
+    EXPECT_TRUE(copy.isDeterministic());
+    EXPECT_EQ(copy.countStates(), 8u);
+    EXPECT_TRUE(copy.isEquivalentTo(fa));
+
+    fa.complementInPlace();
+    EXPECT_TRUE(fa.isDeterministic());
+    EXPECT_TRUE(fa.isComplete());
+    EXPECT_TRUE(fa.isEquivalentTo(reference));
+    EXPECT_TRUE(fa.match("bb"));
+    EXPECT_FALSE(fa.match("abb"));
+}
+
+TEST(AutomatonInPlace, RvalueOverloads) {
+    fa::Automaton word = createWord("ab", 0);
+
+    fa::Automaton complete = fa::Automaton::createComplete(createWord("ab", 0));
+    EXPECT_TRUE(complete.isComplete());
+    EXPECT_TRUE(complete.isEquivalentTo(word));
+
+    fa::Automaton mirror = fa::Automaton::createMirror(createWord("ab", 0));
+    EXPECT_TRUE(mirror.isEquivalentTo(fa::Automaton::createMirror(word)));
+    EXPECT_TRUE(mirror.match("ba"));
+    EXPECT_FALSE(mirror.match("ab"));
+
+    fa::Automaton complement = fa::Automaton::createComplement(createWord("ab", 0));
+    EXPECT_TRUE(complement.isEquivalentTo(fa::Automaton::createComplement(word)));
+
+    fa::Automaton nfa = createKthFromEnd(3);
+    fa::Automaton dfa = fa::Automaton::createDeterministic(std::move(nfa));
+    EXPECT_TRUE(dfa.isDeterministic());
+    EXPECT_EQ(dfa.countStates(), 16u);
+}
+
+// --- MEMORY RESOURCES ---
+
+namespace {
+
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        std::size_t allocations = 0;
+        std::size_t live = 0;
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            live += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            live -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+}
+
+TEST(AutomatonMemoryResource, Containers) {
+    CountingResource resource;
+    {
+        fa::Automaton fa(&resource);
+        EXPECT_EQ(fa.memoryResource(), &resource);
+        fa.addSymbol('a');
+        fa.addState(0);
+        fa.addState(1);
+        fa.addTransition(0, 'a', 1);
+        EXPECT_GT(resource.allocations, 0u);
+        EXPECT_GT(resource.live, 0u);
+
+        fa::Automaton copy = fa;
+        EXPECT_EQ(copy.memoryResource(), std::pmr::get_default_resource());
+        fa::Automaton moved = std::move(fa);
+        EXPECT_EQ(moved.memoryResource(), &resource);
+        fa::Automaton other(copy, &resource);
+        EXPECT_EQ(other.memoryResource(), &resource);
+        EXPECT_TRUE(other.hasTransition(0, 'a', 1));
+    }
+    EXPECT_EQ(resource.live, 0u);
+}
+
+TEST(AutomatonMemoryResource, Operations) {
+    CountingResource resource;
+    {
+        fa::Automaton fa(createKthFromEnd(6), &resource);
+        std::size_t before = resource.allocations;
+
+        fa::Automaton dfa = fa::Automaton::createDeterministic(fa);
+        EXPECT_EQ(dfa.memoryResource(), &resource);
+        EXPECT_EQ(dfa.countStates(), 128u);
+        EXPECT_GT(resource.allocations, before);
+
+        EXPECT_EQ(fa::Automaton::createDeterministic(fa, 2).memoryResource(), &resource);
+        EXPECT_EQ(fa::Automaton::createComplete(dfa).memoryResource(), &resource);
+        EXPECT_EQ(fa::Automaton::createComplement(fa).memoryResource(), &resource);
+        EXPECT_EQ(fa::Automaton::createMirror(fa).memoryResource(), &resource);
+        EXPECT_EQ(fa::Automaton::createIntersection(fa, dfa).memoryResource(), &resource);
+        EXPECT_EQ(fa::Automaton::createMinimalHopcroft(fa).memoryResource(), &resource);
+        EXPECT_EQ(fa::Automaton::createKleeneStar(fa).memoryResource(), &resource);
+    }
+    EXPECT_EQ(resource.live, 0u);
+}
+
+TEST(AutomatonMemoryResource, Arena) {
+    std::pmr::monotonic_buffer_resource arena;
+    fa::Automaton fa(createKthFromEnd(4), &arena);
+    fa::Automaton dfa = fa::Automaton::createDeterministic(fa);
+    EXPECT_TRUE(dfa.isEquivalentTo(fa));
+    EXPECT_TRUE(fa::Automaton::createIntersection(dfa, fa).isEquivalentTo(fa));
+}
+
+TEST(AutomatonMemoryResource, Temporaries) {
+    CountingResource resource;
+    CountingResource defaults;
+    fa::Automaton fa(createKthFromEnd(5), &resource);
+    fa.addState(100);
+    fa.addTransition(100, fa::Epsilon, 0);
+    fa.setStateInitial(100);
+    fa::Automaton other(createKthFromEnd(3), &resource);
+
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&defaults);
+    std::size_t before = resource.allocations;
+    {
+        fa::Automaton dfa = fa::Automaton::createDeterministic(fa);
+        fa::Automaton product = fa::Automaton::createIntersection(fa, other);
+        EXPECT_FALSE(fa.hasEmptyIntersectionWith(other));
+        EXPECT_TRUE(dfa.isDeterministic());
+        for (std::string word : { "abbbbb", "babbbbb", "bbbbbb" }) {
+            EXPECT_EQ(dfa.match(word), fa.match(word));
+        }
+        EXPECT_TRUE(product.match("aaaaaa"));
+        EXPECT_FALSE(product.match("abbbbb"));
+    }
+    std::pmr::set_default_resource(previous);
+    EXPECT_GT(resource.allocations, before);
+    EXPECT_EQ(defaults.allocations, 0u);
+}
+
+TEST(AutomatonMemoryResource, Move) {
+    EXPECT_TRUE(std::is_nothrow_move_constructible_v<fa::Automaton>);
+
+    CountingResource arena;
+    CountingResource defaults;
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&defaults);
+    {
+        // the vector moves the automata, with their closures, as it grows
+        std::vector<fa::Automaton> automata;
+        for (int i = 0; i < 10; ++i) {
+            fa::Automaton fa(&arena);
+            fa.addSymbol('a');
+            fa.addState(0);
+            fa.addState(1);
+            fa.addState(2);
+            fa.setStateInitial(0);
+            fa.setStateFinal(2);
+            fa.addTransition(0, fa::Epsilon, 1);
+            fa.addTransition(1, 'a', 2);
+            EXPECT_TRUE(fa.match("a"));
+            automata.push_back(std::move(fa));
+        }
+        for (auto& fa : automata) {
+            EXPECT_EQ(fa.memoryResource(), &arena);
+            EXPECT_TRUE(fa.match("a"));
+            fa.addTransition(2, fa::Epsilon, 0);
+            EXPECT_TRUE(fa.match("aa"));
+        }
+        fa::Automaton moved(&arena);
+        moved = std::move(automata.back());
+        EXPECT_TRUE(moved.match("aa"));
+    }
+    std::pmr::set_default_resource(previous);
+    EXPECT_EQ(defaults.allocations, 0u);
+    EXPECT_EQ(arena.live, 0u);
+}
+
+// --- COPY-ON-WRITE ---
+
+TEST(AutomatonCopyOnWrite, CopyShares) {
+    CountingResource resource;
+    {
+        fa::Automaton fa(createKthFromEnd(8), &resource);
+        fa::Automaton dfa = fa::Automaton::createDeterministic(fa);
+        ASSERT_EQ(dfa.countStates(), 512u);
+
+        // only the alphabet is copied
+        std::size_t before = resource.allocations;
+        fa::Automaton copy(dfa, &resource);
+        EXPECT_LE(resource.allocations - before, dfa.countSymbols());
+        before = resource.allocations;
+        EXPECT_EQ(fa::Automaton::createDeterministic(dfa).memoryResource(), &resource);
+        EXPECT_LE(resource.allocations - before, dfa.countSymbols());
+        expectSameAutomaton(copy, dfa, "ab");
+
+        // the table of the edges and the modified list only
+        before = resource.allocations;
+        EXPECT_TRUE(copy.removeTransition(0, 'a', 1));
+        EXPECT_LT(resource.allocations - before, 8u);
+        EXPECT_TRUE(dfa.hasTransition(0, 'a', 1));
+        EXPECT_FALSE(copy.hasTransition(0, 'a', 1));
+        EXPECT_EQ(copy.countTransitions() + 1, dfa.countTransitions());
+    }
+    EXPECT_EQ(resource.live, 0u);
+}
+
+TEST(AutomatonCopyOnWrite, ModifiedCopyLeavesOriginal) {
+    fa::Automaton fa = fa::Automaton::createDeterministic(createKthFromEnd(4));
+    fa::Automaton snapshot(fa, std::pmr::new_delete_resource());
+    fa::Automaton copy = fa;
+
+    EXPECT_TRUE(copy.addTransition(0, 'a', 0));
+    copy.setStateFinal(0);
+    EXPECT_TRUE(copy.removeState(3));
+    EXPECT_TRUE(copy.addState(100));
+    EXPECT_TRUE(copy.addTransition(100, 'b', 100));
+    EXPECT_TRUE(copy.removeSymbol('b'));
+    copy.makeComplete();
+    copy.removeNonAccessibleStates();
+    expectSameAutomaton(fa, snapshot, "ab");
+
+    fa::Automaton mirror = fa::Automaton::createMirror(fa::Automaton(fa));
+    fa::Automaton complement = fa::Automaton::createComplement(fa::Automaton(fa));
+    expectSameAutomaton(fa, snapshot, "ab");
+    EXPECT_TRUE(mirror.isEquivalentTo(fa::Automaton::createMirror(snapshot)));
+    EXPECT_TRUE(complement.hasEmptyIntersectionWith(fa));
+}
+
+TEST(AutomatonCopyOnWrite, ModifiedOriginalLeavesCopy) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.addState(1);
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+    fa.addTransition(0, fa::Epsilon, 1);
+    fa.addTransition(1, 'a', 1);
+    EXPECT_TRUE(fa.match(""));
+
+    fa::Automaton copy = fa;
+    fa.removeTransition(0, fa::Epsilon, 1);
+    fa.addTransition(0, 'a', 1);
+    EXPECT_FALSE(fa.match(""));
+    EXPECT_TRUE(copy.match(""));
+    EXPECT_TRUE(copy.match("aa"));
+    EXPECT_FALSE(copy.hasTransition(0, 'a', 1));
+
+    fa = copy;
+    EXPECT_TRUE(fa.match(""));
+    copy.removeState(1);
+    EXPECT_TRUE(fa.match("a"));
+    EXPECT_EQ(fa.countStates(), 2u);
+}
+
+TEST(AutomatonCopyOnWrite, CopiesReleasedInThreads) {
+    fa::Automaton fa = createKthFromEnd(6);
+    for (int round = 0; round < 20; ++round) {
+        // the copies are read then destroyed while the original is modified
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([copy = fa, &errors, round]() {
+                if (!copy.match("a" + std::string(6 + round, 'b'))) ++errors;
+                if (copy.match("b" + std::string(6, 'a'))) ++errors;
+            });
+        }
+        for (int i = 0; i < 8; ++i) {
+            fa.removeTransition(0, 'b', 0);
+            fa.addTransition(0, 'b', 0);
+        }
+        fa.addState(8 + round);
+        fa.addTransition(7 + round, 'b', 8 + round);
+        fa.setStateFinal(8 + round);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(errors.load(), 0);
+    }
+    EXPECT_TRUE(fa.match("a" + std::string(25, 'b')));
+}
+
+// --- REVERSE INDEX ---
+
+TEST(AutomatonReverseIndex, Default) {
+    fa::Automaton fa;
+    EXPECT_FALSE(fa.hasReverseIndex());
+    fa.setReverseIndex(true);
+    EXPECT_TRUE(fa.hasReverseIndex());
+    fa::Automaton copy = fa;
+    EXPECT_TRUE(copy.hasReverseIndex());
+    fa.setReverseIndex(false);
+    EXPECT_FALSE(fa.hasReverseIndex());
+}
+
+TEST(AutomatonReverseIndex, RemoveState) {
+    fa::Automaton indexed = createKthFromEnd(5);
+    indexed.setReverseIndex(true);
+    fa::Automaton plain = createKthFromEnd(5);
+
+    for (int state : { 3, 0, 5 }) {
+        EXPECT_TRUE(indexed.removeState(state));
+        EXPECT_TRUE(plain.removeState(state));
+        EXPECT_EQ(indexed.countStates(), plain.countStates());
+        EXPECT_EQ(indexed.countTransitions(), plain.countTransitions());
+    }
+    EXPECT_FALSE(indexed.removeState(3));
+    for (int from : { 1, 2, 4 }) {
+        for (int to : { 1, 2, 4 }) {
+            for (char c : { 'a', 'b' }) {
+                EXPECT_EQ(indexed.hasTransition(from, c, to), plain.hasTransition(from, c, to));
+            }
+        }
+    }
+}
+
+TEST(AutomatonReverseIndex, RemoveStateWithLoops) {
+    fa::Automaton fa;
+    fa.setReverseIndex(true);
+    fa.addSymbol('a');
+    for (int state = 0; state < 4; ++state) {
+        fa.addState(state);
+        fa.addTransition(state, 'a', state);
+    }
+    fa.addTransition(0, fa::Epsilon, 1);
+    fa.addTransition(1, 'a', 3);
+    fa.addTransition(3, 'a', 2);
+    fa.addTransition(2, fa::Epsilon, 3);
+    fa.setStateInitial(0);
+    fa.setStateFinal(2);
+
+    EXPECT_TRUE(fa.removeState(1));
+    EXPECT_EQ(fa.countTransitions(), 5u);
+    EXPECT_TRUE(fa.hasEpsilonTransition());
+    EXPECT_TRUE(fa.hasTransition(3, 'a', 3));
+    EXPECT_TRUE(fa.hasTransition(3, 'a', 2));
+    EXPECT_TRUE(fa.hasTransition(2, fa::Epsilon, 3));
+
+    EXPECT_TRUE(fa.removeState(3));
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_EQ(fa.countTransitions(), 2u);
+    fa.removeNonCoAccessibleStates();
+    EXPECT_EQ(fa.countStates(), 1u);
+    EXPECT_TRUE(fa.hasState(2));
+}
+
+TEST(AutomatonReverseIndex, RemoveStateCountsEpsilon) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.addState(1);
+    fa.addState(2);
+    fa.addTransition(0, fa::Epsilon, 1);
+    fa.addTransition(0, 'a', 2);
+    fa.addTransition(2, 'a', 1);
+
+    EXPECT_TRUE(fa.removeState(1));
+    EXPECT_FALSE(fa.hasEpsilonTransition());
+    EXPECT_EQ(fa.countTransitions(), 1u);
+}
+
+TEST(AutomatonReverseIndex, InPlaceOperations) {
+    fa::Automaton fa = createKthFromEnd(4);
+    fa.setReverseIndex(true);
+
+    fa::Automaton mirror = fa::Automaton::createMirror(fa::Automaton(fa));
+    EXPECT_TRUE(mirror.hasReverseIndex());
+    EXPECT_TRUE(mirror.isEquivalentTo(fa::Automaton::createMirror(createKthFromEnd(4))));
+
+    fa.complementInPlace();
+    EXPECT_TRUE(fa.hasReverseIndex());
+    EXPECT_TRUE(fa.isEquivalentTo(fa::Automaton::createComplement(createKthFromEnd(4))));
+
+    fa.removeNonCoAccessibleStates();
+    fa.removeState(0);
+    fa.removeNonAccessibleStates();
+    fa::Automaton plain(fa);
+    plain.setReverseIndex(false);
+    plain.removeNonCoAccessibleStates();
+    fa.removeNonCoAccessibleStates();
+    EXPECT_EQ(fa.countStates(), plain.countStates());
+    EXPECT_EQ(fa.countTransitions(), plain.countTransitions());
+}
+
+// --- BUILDER ---
+
+TEST(AutomatonBuilder, SameAsAutomaton) {
+    fa::Automaton expected;
+    fa::AutomatonBuilder builder;
+    builder.reserve(20, 200);
+    for (char c : std::string("abc")) {
+        expected.addSymbol(c);
+        builder.addSymbol(c);
+    }
+    for (int state = 0; state < 20; ++state) {
+        expected.addState(state);
+        builder.addState(state);
+    }
+    expected.setStateInitial(0);
+    builder.setStateInitial(0);
+    for (int state : { 0, 7, 19 }) {
+        expected.setStateFinal(state);
+        builder.setStateFinal(state);
+    }
+
+    std::vector<fa::Transition> transitions;
+    for (int i = 0; i < 200; ++i) {
+        fa::Transition transition = { (i * 7) % 20, "abc"[i % 3], (i * 13) % 20 };
+        expected.addTransition(transition.from, transition.symbol, transition.to);
+        transitions.push_back(transition);
+    }
+    builder.addTransitions(transitions);
+    builder.addTransitions(transitions);
+
+    fa::Automaton fa = builder.build();
+    EXPECT_EQ(fa.countSymbols(), 3u);
+    expectSameAutomaton(fa, expected, "abc");
+    EXPECT_TRUE(fa.isEquivalentTo(expected));
+}
+
+TEST(AutomatonBuilder, ImplicitStatesAndSymbols) {
+    fa::AutomatonBuilder builder;
+    builder.addTransition(1, 'a', 2);
+    builder.addTransition(2, 'b', 2);
+    builder.addTransition(2, fa::Epsilon, 3);
+    builder.setStateInitial(1);
+    builder.setStateFinal(3);
+    builder.setStateInitial(3);
+    builder.addState(10);
+
+    fa::Automaton fa = builder.build();
+    EXPECT_EQ(fa.countStates(), 4u);
+    EXPECT_TRUE(fa.hasState(10));
+    EXPECT_EQ(fa.countSymbols(), 2u);
+    EXPECT_EQ(fa.countTransitions(), 3u);
+    EXPECT_TRUE(fa.hasEpsilonTransition());
+    EXPECT_TRUE(fa.isStateInitial(3));
+    EXPECT_TRUE(fa.isStateFinal(3));
+    EXPECT_TRUE(fa.match(""));
+    EXPECT_TRUE(fa.match("abbb"));
+    EXPECT_FALSE(fa.match("b"));
+}
+
+TEST(AutomatonBuilder, SparseIds) {
+    fa::AutomatonBuilder builder;
+    builder.addTransition(2000000000, 'a', 5);
+    builder.addTransition(5, 'a', 1000000);
+    builder.addTransition(5, 'a', 1000000);
+    builder.setStateInitial(2000000000);
+    builder.setStateFinal(1000000);
+
+    fa::Automaton fa = builder.build();
+    EXPECT_EQ(fa.countStates(), 3u);
+    EXPECT_EQ(fa.countTransitions(), 2u);
+    EXPECT_TRUE(fa.hasTransition(2000000000, 'a', 5));
+    EXPECT_TRUE(fa.hasTransition(5, 'a', 1000000));
+    EXPECT_TRUE(fa.match("aa"));
+    EXPECT_FALSE(fa.match("a"));
+}
+
+TEST(AutomatonBuilder, Invalid) {
+    fa::AutomatonBuilder builder;
+    EXPECT_THROW(builder.addSymbol(fa::Epsilon), std::invalid_argument);
+    EXPECT_THROW(builder.addSymbol('\n'), std::invalid_argument);
+    EXPECT_THROW(builder.addState(-1), std::invalid_argument);
+    EXPECT_THROW(builder.setStateFinal(-2), std::invalid_argument);
+    EXPECT_THROW(builder.addTransition(0, ' ', 1), std::invalid_argument);
+
+    std::vector<fa::Transition> transitions = { { 0, 'a', 1 }, { 1, 'b', -1 } };
+    EXPECT_THROW(builder.addTransitions(transitions), std::invalid_argument);
+    fa::Automaton fa = builder.build();
+    EXPECT_EQ(fa.countStates(), 0u);
+    EXPECT_EQ(fa.countTransitions(), 0u);
+}
+
+TEST(AutomatonBuilder, Reuse) {
+    CountingResource resource;
+    {
+        fa::AutomatonBuilder builder(&resource);
+        builder.addTransition(0, 'a', 1);
+        fa::Automaton first = builder.build();
+        EXPECT_EQ(first.memoryResource(), &resource);
+        EXPECT_EQ(first.countTransitions(), 1u);
+
+        builder.addTransition(3, 'b', 3);
+        fa::Automaton second = builder.build();
+        EXPECT_EQ(second.countStates(), 1u);
+        EXPECT_EQ(second.countSymbols(), 1u);
+        EXPECT_TRUE(second.hasTransition(3, 'b', 3));
+
+        fa::Automaton empty = builder.build();
+        EXPECT_EQ(empty.countStates(), 0u);
+        EXPECT_EQ(empty.countSymbols(), 0u);
+    }
+    EXPECT_EQ(resource.live, 0u);
+}
+
 // --- ISEMPTY ---
 
 int main(int argc, char **argv)